@@ -44,6 +44,13 @@ TYPES_MAP = {
     'mat4x4': 'Matrix4x4'
 }
 
+# Managed types which are marshalled as another manifest type, selected per method with --types
+OVERRIDE_TYPES = {
+    'float*': {'Vector2[]', 'Vector3[]', 'Vector4[]', 'Matrix4x4[]'},
+    'uint8*': {'bool[][]', 'char[][]', 'sbyte[][]', 'short[][]', 'int[][]', 'long[][]', 'byte[][]', 'ushort[][]',
+               'uint[][]', 'ulong[][]', 'IntPtr[][]', 'float[][]', 'double[][]', 'string[][]'}
+}
+
 INVALID_NAMES = {
     "abstract",
     "as",
@@ -184,11 +191,34 @@ def validate_manifest(pplugin):
     return parse_errors
 
 
-def convert_type(type_name, is_ref=False):
+def validate_types(pplugin, types):
+    parse_errors = []
+    methods = {method.get('name'): method for method in pplugin['exportedMethods']}
+    for method_name, overrides in types.items():
+        method = methods.get(method_name)
+        if method is None:
+            parse_errors += [f'types.{method_name} not exported']
+            continue
+        if type(overrides) is not dict:
+            parse_errors += [f'types.{method_name} not object']
+            continue
+        properties = {param.get('name'): param for param in method['paramTypes']}
+        properties['retType'] = method['retType']
+        for name, managed_type in overrides.items():
+            prop = properties.get(name)
+            if prop is None:
+                parse_errors += [f'types.{method_name}.{name} not a parameter']
+            elif managed_type not in OVERRIDE_TYPES.get(prop.get('type'), ()):
+                parse_errors += [f'types.{method_name}.{name} can not be {managed_type} for {prop.get("type")}']
+    return parse_errors
+
+
+def convert_type(type_name, is_ref=False, override=None):
+    type = override if override else TYPES_MAP.get(type_name, 'int')
     if is_ref:
-        return 'ref ' + TYPES_MAP.get(type_name, 'int')
+        return 'ref ' + type
     else:
-        return TYPES_MAP.get(type_name, 'int')
+        return type
 
 
 def generate_name(name):
@@ -204,16 +234,16 @@ class ParamGen(Enum):
     TypesNames = 3
 
 
-def gen_params_string(params, param_gen: ParamGen):
+def gen_params_string(params, param_gen: ParamGen, overrides={}):
     def gen_param(param):
         if param_gen == ParamGen.Types:
-            type = convert_type(param['type'], 'ref' in param and param['ref'] is True)
+            type = convert_type(param['type'], 'ref' in param and param['ref'] is True, overrides.get(param['name']))
             if 'delegate' in type and 'prototype' in param:
                 type = generate_name(param['prototype']['name'])
             return type
         if param_gen == ParamGen.Names:
             return generate_name(param['name'])
-        type = convert_type(param['type'], 'ref' in param and param['ref'] is True)
+        type = convert_type(param['type'], 'ref' in param and param['ref'] is True, overrides.get(param['name']))
         if 'delegate' in type and 'prototype' in param:
             type = generate_name(param['prototype']['name'])
         return f'{type} {generate_name(param["name"])}'
@@ -234,10 +264,13 @@ def gen_delegate(prototype):
             f'{prototype["name"]}({gen_params_string(prototype["paramTypes"], ParamGen.TypesNames)});\n')
 
 
-def main(manifest_path, output_dir, override):
+def main(manifest_path, output_dir, override, types_path):
     if not os.path.isfile(manifest_path):
         print(f'Manifest file not exists {manifest_path}')
         return 1
+    if types_path and not os.path.isfile(types_path):
+        print(f'Types file not exists {types_path}')
+        return 1
     if not os.path.isdir(output_dir):
         print(f'Output folder not exists {output_dir}')
         return 1
@@ -254,7 +287,14 @@ def main(manifest_path, output_dir, override):
     with open(manifest_path, 'r', encoding='utf-8') as fd:
         pplugin = json.load(fd)
 
+    types = {}
+    if types_path:
+        with open(types_path, 'r', encoding='utf-8') as fd:
+            types = json.load(fd)
+
     parse_errors = validate_manifest(pplugin)
+    if not parse_errors and types:
+        parse_errors = validate_types(pplugin, types)
     if parse_errors:
         print('Parse fail:')
         for error in parse_errors:
@@ -286,10 +326,11 @@ def main(manifest_path, output_dir, override):
     content += '\n'
     for method in pplugin['exportedMethods']:
         content += "\t\t[MethodImplAttribute(MethodImplOptions.InternalCall)]\n"
+        overrides = types.get(method['name'], {})
         ret_type = method['retType']
-        return_type = convert_type(ret_type['type'], 'ref' in ret_type and ret_type['ref'] is True)
+        return_type = convert_type(ret_type['type'], 'ref' in ret_type and ret_type['ref'] is True, overrides.get('retType'))
         content += (f'\t\tinternal static extern {return_type} '
-                    f'{method["name"]}({gen_params_string(method["paramTypes"], ParamGen.TypesNames)});\n')
+                    f'{method["name"]}({gen_params_string(method["paramTypes"], ParamGen.TypesNames, overrides)});\n')
     content += '\t}\n'
     content += '}\n'
 
@@ -304,9 +345,10 @@ def get_args():
     parser.add_argument('manifest')
     parser.add_argument('output')
     parser.add_argument('--override')
+    parser.add_argument('--types', help='JSON file with managed types of parameters and returns, by method and parameter name')
     return parser.parse_args()
 
 
 if __name__ == '__main__':
     args = get_args()
-    sys.exit(main(args.manifest, args.output, args.override))
+    sys.exit(main(args.manifest, args.output, args.override, args.types))
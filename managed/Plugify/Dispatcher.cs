@@ -0,0 +1,205 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Reflection;
+using System.Reflection.Emit;
+using System.Runtime.ExceptionServices;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Fans out a single call from the language module to every subscribed plugin.
+	/// </summary>
+	internal static class Dispatcher
+	{
+		internal delegate void BatchInvoker(object target, IntPtr columns, IntPtr results, int count);
+
+		private static Action<float>[] _updates = new Action<float>[0];
+		private static BatchInvoker[] _batches = new BatchInvoker[0];
+		private static readonly object _batchLock = new object();
+
+		/// <summary>
+		/// Called by the language module when the set of started plugins changes.
+		/// Plugins are already in tick order, the ones without OnUpdate(float) are skipped.
+		/// </summary>
+		internal static int SetUpdateTargets(Plugin[] plugins)
+		{
+			var updates = new List<Action<float>>(plugins.Length);
+			foreach (var plugin in plugins)
+			{
+				var method = plugin.GetType().GetMethod("OnUpdate", BindingFlags.Instance | BindingFlags.Public | BindingFlags.NonPublic, null, new[] { typeof(float) }, null);
+				if (method == null || method.ReturnType != typeof(void))
+					continue;
+				updates.Add((Action<float>) Delegate.CreateDelegate(typeof(Action<float>), plugin, method));
+			}
+			_updates = updates.ToArray();
+			return _updates.Length;
+		}
+
+		internal static void Update(float deltaTime)
+		{
+			List<Exception> exceptions = null;
+			foreach (var update in _updates)
+			{
+				try
+				{
+					update(deltaTime);
+				}
+				catch (Exception e)
+				{
+					// One failing plugin should not stop the tick of the others
+					if (exceptions == null)
+						exceptions = new List<Exception>();
+					exceptions.Add(e);
+				}
+			}
+
+			if (exceptions == null)
+				return;
+			if (exceptions.Count == 1)
+				ExceptionDispatchInfo.Capture(exceptions[0]).Throw();
+			throw new AggregateException(exceptions);
+		}
+
+		/// <summary>
+		/// Compiles a loop which calls the method once per element of the native argument columns.
+		/// Sizes holds the native element size of every column, the last one is the size of the result element.
+		/// </summary>
+		internal static int CreateBatch(MethodInfo method, byte[] sizes)
+		{
+			var parameters = method.GetParameters();
+			var dynamicMethod = new DynamicMethod(method.Name + "Batch", typeof(void), new[] { typeof(object), typeof(IntPtr), typeof(IntPtr), typeof(int) }, typeof(Dispatcher).Module, true);
+			var il = dynamicMethod.GetILGenerator();
+			var index = il.DeclareLocal(typeof(int));
+			var loop = il.DefineLabel();
+			var check = il.DefineLabel();
+
+			il.Emit(OpCodes.Ldc_I4_0);
+			il.Emit(OpCodes.Stloc, index);
+			il.Emit(OpCodes.Br, check);
+			il.MarkLabel(loop);
+
+			// results + index * size
+			var resultSize = sizes[parameters.Length];
+			if (method.ReturnType != typeof(void))
+			{
+				il.Emit(OpCodes.Ldarg_2);
+				EmitElementOffset(il, index, resultSize);
+			}
+
+			if (!method.IsStatic)
+			{
+				il.Emit(OpCodes.Ldarg_0);
+				il.Emit(OpCodes.Castclass, method.DeclaringType);
+			}
+
+			// columns[i] + index * size
+			for (int i = 0; i < parameters.Length; ++i)
+			{
+				il.Emit(OpCodes.Ldarg_1);
+				il.Emit(OpCodes.Ldc_I4, i * IntPtr.Size);
+				il.Emit(OpCodes.Add);
+				il.Emit(OpCodes.Ldind_I);
+				EmitElementOffset(il, index, sizes[i]);
+				EmitLoad(il, parameters[i].ParameterType, sizes[i]);
+			}
+
+			il.Emit(method.IsStatic ? OpCodes.Call : OpCodes.Callvirt, method);
+
+			if (method.ReturnType != typeof(void))
+				EmitStore(il, method.ReturnType, resultSize);
+
+			il.Emit(OpCodes.Ldloc, index);
+			il.Emit(OpCodes.Ldc_I4_1);
+			il.Emit(OpCodes.Add);
+			il.Emit(OpCodes.Stloc, index);
+			il.MarkLabel(check);
+			il.Emit(OpCodes.Ldloc, index);
+			il.Emit(OpCodes.Ldarg_3);
+			il.Emit(OpCodes.Blt, loop);
+			il.Emit(OpCodes.Ret);
+
+			var invoker = (BatchInvoker) dynamicMethod.CreateDelegate(typeof(BatchInvoker));
+			lock (_batchLock)
+			{
+				// Copy on write, so InvokeBatch can read without lock
+				var batches = new BatchInvoker[_batches.Length + 1];
+				Array.Copy(_batches, batches, _batches.Length);
+				batches[_batches.Length] = invoker;
+				_batches = batches;
+				return _batches.Length - 1;
+			}
+		}
+
+		internal static void InvokeBatch(int id, object target, IntPtr columns, IntPtr results, int count)
+		{
+			_batches[id](target, columns, results, count);
+		}
+
+		private static void EmitElementOffset(ILGenerator il, LocalBuilder index, byte size)
+		{
+			il.Emit(OpCodes.Ldloc, index);
+			il.Emit(OpCodes.Conv_I);
+			il.Emit(OpCodes.Ldc_I4, (int) size);
+			il.Emit(OpCodes.Mul);
+			il.Emit(OpCodes.Add);
+		}
+
+		private static void EmitLoad(ILGenerator il, Type type, byte size)
+		{
+			if (type == typeof(bool) || type == typeof(byte))
+				il.Emit(OpCodes.Ldind_U1);
+			else if (type == typeof(sbyte))
+				il.Emit(OpCodes.Ldind_I1);
+			else if (type == typeof(char))
+				il.Emit(size == 1 ? OpCodes.Ldind_U1 : OpCodes.Ldind_U2);
+			else if (type == typeof(short))
+				il.Emit(OpCodes.Ldind_I2);
+			else if (type == typeof(ushort))
+				il.Emit(OpCodes.Ldind_U2);
+			else if (type == typeof(int))
+				il.Emit(OpCodes.Ldind_I4);
+			else if (type == typeof(uint))
+				il.Emit(OpCodes.Ldind_U4);
+			else if (type == typeof(long) || type == typeof(ulong))
+				il.Emit(OpCodes.Ldind_I8);
+			else if (type == typeof(IntPtr) || type == typeof(UIntPtr))
+				il.Emit(OpCodes.Ldind_I);
+			else if (type == typeof(float))
+				il.Emit(OpCodes.Ldind_R4);
+			else if (type == typeof(double))
+				il.Emit(OpCodes.Ldind_R8);
+			else
+				throw new NotSupportedException($"Type '{type}' can't be used in batch call");
+		}
+
+		private static void EmitStore(ILGenerator il, Type type, byte size)
+		{
+			if (type == typeof(bool) || type == typeof(byte) || type == typeof(sbyte))
+				il.Emit(OpCodes.Stind_I1);
+			else if (type == typeof(char))
+			{
+				if (size == 1)
+				{
+					il.Emit(OpCodes.Conv_U1);
+					il.Emit(OpCodes.Stind_I1);
+				}
+				else
+					il.Emit(OpCodes.Stind_I2);
+			}
+			else if (type == typeof(short) || type == typeof(ushort))
+				il.Emit(OpCodes.Stind_I2);
+			else if (type == typeof(int) || type == typeof(uint))
+				il.Emit(OpCodes.Stind_I4);
+			else if (type == typeof(long) || type == typeof(ulong))
+				il.Emit(OpCodes.Stind_I8);
+			else if (type == typeof(IntPtr) || type == typeof(UIntPtr))
+				il.Emit(OpCodes.Stind_I);
+			else if (type == typeof(float))
+				il.Emit(OpCodes.Stind_R4);
+			else if (type == typeof(double))
+				il.Emit(OpCodes.Stind_R8);
+			else
+				throw new NotSupportedException($"Type '{type}' can't be used in batch call");
+		}
+	}
+}
\ No newline at end of file
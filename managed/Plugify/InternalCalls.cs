@@ -1,4 +1,5 @@
-﻿using System.Runtime.CompilerServices;
+﻿using System;
+using System.Runtime.CompilerServices;
 
 namespace Plugify
 {
@@ -19,5 +20,34 @@ namespace Plugify
 		[MethodImplAttribute(MethodImplOptions.InternalCall)]
 		internal static extern string Plugin_FindResource(string name, string path);
 		#endregion
+
+		#region Batch
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern Array Batch_Invoke(string name, Array[] columns);
+		#endregion
+
+		#region NativeVector
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern IntPtr NativeVector_GetData(IntPtr container);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern int NativeVector_GetSize(IntPtr container);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern void NativeVector_Resize(IntPtr container, int size);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern void NativeVector_Append(IntPtr container, IntPtr element);
+		#endregion
+
+		#region ArrayStream
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern IntPtr ArrayStream_Open(string name, Type elementType);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern long ArrayStream_GetLength(IntPtr stream);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern long ArrayStream_GetPosition(IntPtr stream);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern int ArrayStream_Read(IntPtr stream, Array buffer, int offset, int count);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern void ArrayStream_Free(IntPtr stream);
+		#endregion
 	}
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Threading;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Native array which is copied out in chunks instead of being materialized as one managed array.
+	/// A stream is either returned by an imported method listed in the "arrayStreams" setting, which still builds
+	/// the whole vector before returning, or opened over a native producer with <see cref="Open{T}"/>,
+	/// which writes every chunk on demand, so neither side ever holds the full array.
+	/// </summary>
+	public sealed unsafe class NativeArrayStream : IDisposable
+	{
+		/// <summary>
+		/// Default chunk stays below the large object threshold of the mono GC (8000 bytes).
+		/// </summary>
+		public const int DefaultChunkBytes = 4096;
+
+		// Set by the language module
+		private IntPtr _stream;
+
+		private NativeArrayStream()
+		{
+		}
+
+		~NativeArrayStream()
+		{
+			Release();
+		}
+
+		/// <summary>
+		/// Opens a stream over an imported native method with the signature uint64 (ptr64 buffer, uint64 offset, uint64 capacity).
+		/// It is called for every read, must write up to capacity elements of T starting at element offset into buffer,
+		/// and returns the number written, 0 once there are no more elements.
+		/// </summary>
+		public static NativeArrayStream Open<T>(string plugin, string method) where T : unmanaged
+		{
+			IntPtr stream = InternalCalls.ArrayStream_Open($"{plugin}.{plugin}::{method}", typeof(T));
+			if (stream == IntPtr.Zero)
+				throw new InvalidOperationException($"Method '{plugin}::{method}' can not be opened as array stream");
+			return new NativeArrayStream { _stream = stream };
+		}
+
+		/// <summary>
+		/// Total number of elements, -1 for a producer stream until it reports the end.
+		/// </summary>
+		public long Length => InternalCalls.ArrayStream_GetLength(Handle);
+
+		public long Position => InternalCalls.ArrayStream_GetPosition(Handle);
+
+		/// <summary>
+		/// Copies next elements into buffer, T must be the managed type of native element (char for char8 arrays),
+		/// other types of the same size are rejected.
+		/// </summary>
+		/// <returns>Number of copied elements, 0 when the end of the array is reached.</returns>
+		public int Read<T>(T[] buffer, int offset, int count) where T : unmanaged
+		{
+			if (buffer == null)
+				throw new ArgumentNullException(nameof(buffer));
+			if (offset < 0 || count < 0 || buffer.Length - offset < count)
+				throw new ArgumentOutOfRangeException(nameof(offset));
+			int read = InternalCalls.ArrayStream_Read(Handle, buffer, offset, count);
+			if (read < 0)
+				throw new ArgumentException($"Element type '{typeof(T)}' does not match the stream", nameof(buffer));
+			return read;
+		}
+
+		/// <summary>
+		/// Enumerates remaining elements chunk by chunk, every chunk reuses the same buffer.
+		/// </summary>
+		public IEnumerable<ArraySegment<T>> ReadChunks<T>(int chunkSize) where T : unmanaged
+		{
+			if (chunkSize <= 0)
+				throw new ArgumentOutOfRangeException(nameof(chunkSize));
+			return ReadChunksIterator<T>(chunkSize);
+		}
+
+		public IEnumerable<ArraySegment<T>> ReadChunks<T>() where T : unmanaged
+		{
+			return ReadChunks<T>(Math.Max(DefaultChunkBytes / sizeof(T), 1));
+		}
+
+		/// <summary>
+		/// Copies all remaining elements into one managed array.
+		/// </summary>
+		public T[] ToArray<T>() where T : unmanaged
+		{
+			long length = Length;
+			if (length < 0)
+				return ToArrayUnbounded<T>();
+
+			var array = new T[length - Position];
+			int offset = 0;
+			int read;
+			while (offset < array.Length && (read = Read(array, offset, array.Length - offset)) != 0)
+			{
+				offset += read;
+			}
+			return array;
+		}
+
+		public void Dispose()
+		{
+			Release();
+			GC.SuppressFinalize(this);
+		}
+
+		// Producer stream has no known length, array grows until the producer reports the end
+		private T[] ToArrayUnbounded<T>() where T : unmanaged
+		{
+			var array = new T[Math.Max(DefaultChunkBytes / sizeof(T), 1)];
+			int offset = 0;
+			int read;
+			while ((read = Read(array, offset, array.Length - offset)) != 0)
+			{
+				offset += read;
+				if (offset == array.Length)
+					Array.Resize(ref array, array.Length * 2);
+			}
+			Array.Resize(ref array, offset);
+			return array;
+		}
+
+		private IEnumerable<ArraySegment<T>> ReadChunksIterator<T>(int chunkSize) where T : unmanaged
+		{
+			long remaining = Length < 0 ? chunkSize : Length - Position;
+			var buffer = new T[(int) Math.Min(chunkSize, Math.Max(remaining, 1))];
+			int read;
+			while ((read = Read(buffer, 0, buffer.Length)) != 0)
+			{
+				yield return new ArraySegment<T>(buffer, 0, read);
+			}
+		}
+
+		private void Release()
+		{
+			IntPtr stream = Interlocked.Exchange(ref _stream, IntPtr.Zero);
+			if (stream != IntPtr.Zero)
+				InternalCalls.ArrayStream_Free(stream);
+		}
+
+		private IntPtr Handle => _stream != IntPtr.Zero ? _stream : throw new ObjectDisposedException(nameof(NativeArrayStream));
+	}
+}
\ No newline at end of file
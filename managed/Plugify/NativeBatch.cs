@@ -0,0 +1,25 @@
+﻿using System;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Calls a method exported by a native plugin once per row of argument columns, crossing into native code only once.
+	/// </summary>
+	public static class NativeBatch
+	{
+		/// <summary>
+		/// Every column holds the values of one parameter and all columns have the same length.
+		/// Only primitive and string parameters and returns are supported.
+		/// </summary>
+		/// <returns>Array with the result of every row, or null for void methods.</returns>
+		public static Array InvokeBatch(string plugin, string method, params Array[] columns)
+		{
+			return InternalCalls.Batch_Invoke($"{plugin}.{plugin}::{method}", columns);
+		}
+
+		public static TResult[] InvokeBatch<TResult>(string plugin, string method, params Array[] columns)
+		{
+			return (TResult[]) InvokeBatch(plugin, method, columns);
+		}
+	}
+}
\ No newline at end of file
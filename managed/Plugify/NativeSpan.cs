@@ -0,0 +1,50 @@
+﻿using System;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Read-only view over std::vector passed by native caller, used as parameter of exported method instead of an array.
+	/// Nothing is copied, so the view is valid only until the method returns, being a ref struct it can not outlive the call.
+	/// </summary>
+	public readonly unsafe ref struct NativeSpan<T> where T : unmanaged
+	{
+		private readonly NativeView* _view;
+
+		public int Length => _view != null ? (int) _view->Size : 0;
+
+		public T this[int index]
+		{
+			get
+			{
+				if ((uint) index >= (uint) Length)
+					throw new IndexOutOfRangeException();
+				return ((T*) _view->Data)[index];
+			}
+		}
+
+		public T[] ToArray()
+		{
+			var array = new T[Length];
+			CopyTo(array, 0);
+			return array;
+		}
+
+		public void CopyTo(T[] destination, int index)
+		{
+			int length = Length;
+			if (destination == null)
+				throw new ArgumentNullException(nameof(destination));
+			if (index < 0 || destination.Length - index < length)
+				throw new ArgumentOutOfRangeException(nameof(index));
+			if (length == 0)
+				return;
+			fixed (T* dest = &destination[index])
+			{
+				Buffer.MemoryCopy((void*) _view->Data, dest, (long) (destination.Length - index) * sizeof(T), (long) length * sizeof(T));
+			}
+		}
+
+		// Called by the language module to verify element layout against native one
+		private static int GetElementSize() => sizeof(T);
+	}
+}
\ No newline at end of file
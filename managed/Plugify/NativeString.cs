@@ -0,0 +1,35 @@
+﻿using System;
+using System.Text;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Read-only view over UTF-8 bytes of std::string passed by native caller, used as parameter of exported method instead of a string.
+	/// Nothing is copied, so the view is valid only until the method returns, being a ref struct it can not outlive the call.
+	/// </summary>
+	public readonly unsafe ref struct NativeString
+	{
+		private readonly NativeView* _view;
+
+		/// <summary>
+		/// Length in bytes.
+		/// </summary>
+		public int Length => _view != null ? (int) _view->Size : 0;
+
+		public byte this[int index]
+		{
+			get
+			{
+				if ((uint) index >= (uint) Length)
+					throw new IndexOutOfRangeException();
+				return ((byte*) _view->Data)[index];
+			}
+		}
+
+		public override string ToString()
+		{
+			int length = Length;
+			return length != 0 ? Encoding.UTF8.GetString((byte*) _view->Data, length) : string.Empty;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+﻿using System;
+using System.Collections;
+using System.Collections.Generic;
+using System.Text;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Array of strings passed by native caller as one UTF-8 blob, used as parameter of exported method instead of string[].
+	/// Elements are decoded on first access and cached, so large arrays where only few elements are read stay cheap.
+	/// </summary>
+	public sealed class NativeStringList : IReadOnlyList<string>
+	{
+		// Set by the language module, offsets has one extra entry with the end of the last string
+		private byte[] _data;
+		private int[] _offsets;
+		private string[] _cache;
+
+		private NativeStringList()
+		{
+		}
+
+		public int Count => _offsets.Length - 1;
+
+		public string this[int index]
+		{
+			get
+			{
+				if ((uint) index >= (uint) Count)
+					throw new IndexOutOfRangeException();
+				if (_cache == null)
+					_cache = new string[Count];
+				return _cache[index] ?? (_cache[index] = Encoding.UTF8.GetString(_data, _offsets[index], _offsets[index + 1] - _offsets[index]));
+			}
+		}
+
+		public string[] ToArray()
+		{
+			var array = new string[Count];
+			for (int i = 0; i < array.Length; ++i)
+			{
+				array[i] = this[i];
+			}
+			return array;
+		}
+
+		public IEnumerator<string> GetEnumerator()
+		{
+			for (int i = 0; i < Count; ++i)
+			{
+				yield return this[i];
+			}
+		}
+
+		IEnumerator IEnumerable.GetEnumerator()
+		{
+			return GetEnumerator();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+﻿using System;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Mutable view over std::vector or std::string (as bytes) passed by reference from native caller,
+	/// used as parameter of exported method instead of ref array. Changes are made to native container directly,
+	/// so the view is valid only until the method returns.
+	/// It is a ref struct, so the compiler keeps it from being stored in a field, boxed or captured.
+	/// </summary>
+	public readonly unsafe ref struct NativeVector<T> where T : unmanaged
+	{
+		private readonly IntPtr _container;
+
+		public int Length => InternalCalls.NativeVector_GetSize(_container);
+
+		public T this[int index]
+		{
+			get
+			{
+				if ((uint) index >= (uint) Length)
+					throw new IndexOutOfRangeException();
+				return ((T*) InternalCalls.NativeVector_GetData(_container))[index];
+			}
+			set
+			{
+				if ((uint) index >= (uint) Length)
+					throw new IndexOutOfRangeException();
+				((T*) InternalCalls.NativeVector_GetData(_container))[index] = value;
+			}
+		}
+
+		public void Resize(int size)
+		{
+			if (size < 0)
+				throw new ArgumentOutOfRangeException(nameof(size));
+			InternalCalls.NativeVector_Resize(_container, size);
+		}
+
+		public void Add(T value)
+		{
+			InternalCalls.NativeVector_Append(_container, (IntPtr) (&value));
+		}
+
+		public void Clear()
+		{
+			InternalCalls.NativeVector_Resize(_container, 0);
+		}
+
+		public T[] ToArray()
+		{
+			int length = Length;
+			var array = new T[length];
+			if (length != 0)
+			{
+				fixed (T* dest = array)
+				{
+					Buffer.MemoryCopy((void*) InternalCalls.NativeVector_GetData(_container), dest, (long) length * sizeof(T), (long) length * sizeof(T));
+				}
+			}
+			return array;
+		}
+
+		// Called by the language module to verify element layout against native one
+		private static int GetElementSize() => sizeof(T);
+	}
+}
\ No newline at end of file
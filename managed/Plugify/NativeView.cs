@@ -0,0 +1,13 @@
+﻿using System;
+
+namespace Plugify
+{
+	/// <summary>
+	/// Pointer and length of native storage, same layout as ArrayView on native side.
+	/// </summary>
+	internal struct NativeView
+	{
+		public IntPtr Data;
+		public UIntPtr Size;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include "aggregate.h"
+
+#include <plugify/math.h>
+
+using namespace monolm;
+using namespace plugify;
+
+namespace {
+	template<size_t N>
+	constexpr std::array<AggregateField, 1> FloatLayout() {
+		return {{ { DC_SIGCHAR_FLOAT, 0, N } }};
+	}
+}
+
+AggregateRegistry::AggregateRegistry() : _builtin{
+	Create(sizeof(Vector2), FloatLayout<2>()),
+	Create(sizeof(Vector3), FloatLayout<3>()),
+	Create(sizeof(Vector4), FloatLayout<4>()),
+	Create(sizeof(Matrix4x4), FloatLayout<16>())
+} {
+}
+
+std::deleted_unique_ptr<DCaggr> AggregateRegistry::Create(size_t size, std::span<const AggregateField> fields) {
+	DCaggr* ag = dcNewAggr(fields.size(), size);
+	for (const auto& field : fields) {
+		dcAggrField(ag, field.type, static_cast<DCint>(field.offset), field.count);
+	}
+	dcCloseAggr(ag);
+	return std::deleted_unique_ptr<DCaggr>(ag, dcFreeAggr);
+}
+
+const DCaggr* AggregateRegistry::Get(ValueType type) const {
+	if (type < ValueType::FirstPOD || type > ValueType::LastPOD)
+		return nullptr;
+	return _builtin[static_cast<size_t>(type) - static_cast<size_t>(ValueType::FirstPOD)].get();
+}
\ No newline at end of file
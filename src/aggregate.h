@@ -0,0 +1,31 @@
+#pragma once
+
+#include <dyncall/dyncall.h>
+#include <plugify/value_type.h>
+
+namespace monolm {
+	struct AggregateField {
+		DCsigchar type;
+		size_t offset;
+		size_t count{ 1 };
+	};
+
+	/// Owns dyncall aggregate descriptors of the built-in vector and matrix layouts.
+	/// They are created up front, so lookup on the call path is lock free.
+	class AggregateRegistry {
+	public:
+		AggregateRegistry();
+		~AggregateRegistry() = default;
+		AggregateRegistry(const AggregateRegistry&) = delete;
+		AggregateRegistry& operator=(const AggregateRegistry&) = delete;
+
+		/// Returns the descriptor for Vector2/3/4 and Matrix4x4, nullptr for other types.
+		const DCaggr* Get(plugify::ValueType type) const;
+
+	private:
+		static std::deleted_unique_ptr<DCaggr> Create(size_t size, std::span<const AggregateField> fields);
+
+	private:
+		std::array<std::deleted_unique_ptr<DCaggr>, 4> _builtin;
+	};
+}
\ No newline at end of file
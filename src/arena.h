@@ -0,0 +1,216 @@
+#pragma once
+
+namespace monolm {
+	/// Vector with inline storage for the first N elements, spills to the heap only after that.
+	template<typename T, size_t N>
+	class InlineVector {
+		static_assert(std::is_trivially_copyable_v<T>);
+	public:
+		InlineVector() = default;
+		InlineVector(const InlineVector&) = delete;
+		InlineVector& operator=(const InlineVector&) = delete;
+
+		void push_back(const T& value) {
+			if (_size == _capacity)
+				reserve(_capacity * 2);
+			_data[_size++] = value;
+		}
+
+		void reserve(size_t capacity) {
+			if (capacity <= _capacity)
+				return;
+			auto heap = std::make_unique<T[]>(capacity);
+			std::memcpy(heap.get(), _data, _size * sizeof(T));
+			_heap = std::move(heap);
+			_data = _heap.get();
+			_capacity = capacity;
+		}
+
+		void clear() { _size = 0; }
+
+		T* data() { return _data; }
+		const T* data() const { return _data; }
+		size_t size() const { return _size; }
+		bool empty() const { return _size == 0; }
+
+		T& operator[](size_t index) { return _data[index]; }
+		const T& operator[](size_t index) const { return _data[index]; }
+
+		T* begin() { return _data; }
+		T* end() { return _data + _size; }
+		const T* begin() const { return _data; }
+		const T* end() const { return _data + _size; }
+
+	private:
+		T _inline[N];
+		T* _data{ _inline };
+		size_t _size{ 0 };
+		size_t _capacity{ N };
+		std::unique_ptr<T[]> _heap;
+	};
+
+	/// Per-thread free list of containers, keeps their capacity between calls.
+	template<typename T>
+	class ObjectPool {
+	public:
+		static constexpr size_t kMaxPooled = 32;
+		static constexpr size_t kMaxRetainedBytes = 64 * 1024;
+
+		~ObjectPool() {
+			for (T* object : _free) {
+				delete object;
+			}
+		}
+
+		static ObjectPool& Get() {
+			thread_local ObjectPool pool;
+			return pool;
+		}
+
+		T* Acquire() {
+			if (_free.empty())
+				return new T();
+			T* object = _free.back();
+			_free.pop_back();
+			return object;
+		}
+
+		void Release(T* object) {
+			if (_free.size() >= kMaxPooled || object->capacity() * sizeof(typename T::value_type) > kMaxRetainedBytes) {
+				delete object;
+				return;
+			}
+			object->clear();
+			_free.push_back(object);
+		}
+
+	private:
+		std::vector<T*> _free;
+	};
+
+	/// Bump allocator for marshalling temporaries. Memory and objects are released in bulk
+	/// by rewinding to a marker, which is done by Arena::Scope at the end of every call.
+	class Arena {
+	public:
+		static constexpr size_t kBlockSize = 16 * 1024;
+
+		Arena() = default;
+		~Arena() { Rewind({}); }
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+
+		struct Record;
+
+		struct Marker {
+			size_t block{ 0 };
+			size_t offset{ 0 };
+			Record* records{ nullptr };
+		};
+
+		class Scope {
+		public:
+			explicit Scope(Arena& arena) : _arena{arena}, _marker{arena.GetMarker()} {}
+			~Scope() { _arena.Rewind(_marker); }
+			Scope(const Scope&) = delete;
+			Scope& operator=(const Scope&) = delete;
+
+		private:
+			Arena& _arena;
+			Marker _marker;
+		};
+
+		void* Allocate(size_t size, size_t alignment) {
+			if (size + alignment > kBlockSize) {
+				auto* large = new std::byte[size];
+				AddRecord(large, &DeleteLarge);
+				return large;
+			}
+
+			if (_blocks.empty())
+				_blocks.push_back(std::make_unique<std::byte[]>(kBlockSize));
+
+			size_t offset = (_offset + alignment - 1) & ~(alignment - 1);
+			if (offset + size > kBlockSize) {
+				if (++_block == _blocks.size())
+					_blocks.push_back(std::make_unique<std::byte[]>(kBlockSize));
+				offset = 0;
+			}
+
+			_offset = offset + size;
+			return _blocks[_block].get() + offset;
+		}
+
+		/// Raw storage for an object which is constructed by someone else (i.e. hidden return),
+		/// its destructor is still invoked on rewind.
+		template<typename T>
+		T* Allocate() {
+			auto* object = static_cast<T*>(Allocate(sizeof(T), alignof(T)));
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				AddRecord(object, &Destroy<T>);
+			return object;
+		}
+
+		template<typename T, typename... Args>
+		T* New(Args&&... args) {
+			auto* object = std::construct_at(static_cast<T*>(Allocate(sizeof(T), alignof(T))), std::forward<Args>(args)...);
+			if constexpr (!std::is_trivially_destructible_v<T>)
+				AddRecord(object, &Destroy<T>);
+			return object;
+		}
+
+		/// Container taken from the per-thread pool, cleared and returned to it on rewind.
+		template<typename T>
+		T* Acquire() {
+			T* object = ObjectPool<T>::Get().Acquire();
+			AddRecord(object, &Recycle<T>);
+			return object;
+		}
+
+		Marker GetMarker() const { return { _block, _offset, _records }; }
+
+		void Rewind(const Marker& marker) {
+			while (_records != marker.records) {
+				Record* record = _records;
+				_records = record->prev;
+				record->release(record->object);
+			}
+			_block = marker.block;
+			_offset = marker.offset;
+		}
+
+		size_t GetReservedBytes() const { return _blocks.size() * kBlockSize; }
+
+		struct Record {
+			void* object;
+			void(*release)(void*);
+			Record* prev;
+		};
+
+	private:
+		void AddRecord(void* object, void(*release)(void*)) {
+			auto* record = static_cast<Record*>(Allocate(sizeof(Record), alignof(Record)));
+			*record = { object, release, _records };
+			_records = record;
+		}
+
+		template<typename T>
+		static void Destroy(void* object) {
+			std::destroy_at(static_cast<T*>(object));
+		}
+
+		template<typename T>
+		static void Recycle(void* object) {
+			ObjectPool<T>::Get().Release(static_cast<T*>(object));
+		}
+
+		static void DeleteLarge(void* object) {
+			delete[] static_cast<std::byte*>(object);
+		}
+
+	private:
+		std::vector<std::unique_ptr<std::byte[]>> _blocks;
+		size_t _block{ 0 };
+		size_t _offset{ 0 };
+		Record* _records{ nullptr };
+	};
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "container.h"
+#include "kernels.h"
+
+using namespace monolm;
+using namespace plugify;
+
+namespace {
+	template<typename F>
+	auto Visit(const ContainerRef& ref, F&& func) {
+		switch (ref.type) {
+			case ValueType::String:
+				return func(*static_cast<std::string*>(ref.container));
+			case ValueType::ArrayChar8:
+				return func(*static_cast<std::vector<char>*>(ref.container));
+			case ValueType::ArrayChar16:
+				return func(*static_cast<std::vector<char16_t>*>(ref.container));
+			case ValueType::ArrayInt8:
+				return func(*static_cast<std::vector<int8_t>*>(ref.container));
+			case ValueType::ArrayInt16:
+				return func(*static_cast<std::vector<int16_t>*>(ref.container));
+			case ValueType::ArrayInt32:
+				return func(*static_cast<std::vector<int32_t>*>(ref.container));
+			case ValueType::ArrayInt64:
+				return func(*static_cast<std::vector<int64_t>*>(ref.container));
+			case ValueType::ArrayUInt8:
+				return func(*static_cast<std::vector<uint8_t>*>(ref.container));
+			case ValueType::ArrayUInt16:
+				return func(*static_cast<std::vector<uint16_t>*>(ref.container));
+			case ValueType::ArrayUInt32:
+				return func(*static_cast<std::vector<uint32_t>*>(ref.container));
+			case ValueType::ArrayUInt64:
+				return func(*static_cast<std::vector<uint64_t>*>(ref.container));
+			case ValueType::ArrayPointer:
+				return func(*static_cast<std::vector<uintptr_t>*>(ref.container));
+			case ValueType::ArrayFloat:
+				return func(*static_cast<std::vector<float>*>(ref.container));
+			case ValueType::ArrayDouble:
+				return func(*static_cast<std::vector<double>*>(ref.container));
+			default:
+				std::puts("Unsupported types!\n");
+				std::terminate();
+		}
+	}
+}
+
+// std::vector<bool> is packed and std::vector<std::string> holds objects, neither can be viewed
+size_t NativeContainer::GetElementSize(ValueType type) {
+	switch (type) {
+		case ValueType::String:
+		case ValueType::ArrayChar8:
+		case ValueType::ArrayInt8:
+		case ValueType::ArrayUInt8:
+			return 1;
+		case ValueType::ArrayChar16:
+		case ValueType::ArrayInt16:
+		case ValueType::ArrayUInt16:
+			return 2;
+		case ValueType::ArrayInt32:
+		case ValueType::ArrayUInt32:
+		case ValueType::ArrayFloat:
+			return 4;
+		case ValueType::ArrayInt64:
+		case ValueType::ArrayUInt64:
+		case ValueType::ArrayDouble:
+			return 8;
+		case ValueType::ArrayPointer:
+			return sizeof(uintptr_t);
+		default:
+			return 0;
+	}
+}
+
+void* NativeContainer::GetData(const ContainerRef& ref) {
+	return Visit(ref, [](auto& container) -> void* { return container.data(); });
+}
+
+size_t NativeContainer::GetSize(const ContainerRef& ref) {
+	return Visit(ref, [](auto& container) { return container.size(); });
+}
+
+void NativeContainer::Resize(const ContainerRef& ref, size_t size) {
+	Visit(ref, [size](auto& container) { container.resize(size); });
+}
+
+void NativeContainer::Append(const ContainerRef& ref, const void* element) {
+	Visit(ref, [element](auto& container) {
+		typename std::decay_t<decltype(container)>::value_type value;
+		std::memcpy(&value, element, sizeof(value));
+		container.push_back(value);
+	});
+}
+
+bool ArrayStream::IsSupported(ValueType type) {
+	return type != ValueType::String && NativeContainer::GetElementSize(type) != 0;
+}
+
+ArrayStream* ArrayStream::Create(ValueType type, void* container, MonoClass* elementClass) {
+	auto* stream = new ArrayStream();
+	stream->_type = type;
+	stream->_elementClass = elementClass;
+	Visit({ container, type }, [stream](auto& source) {
+		using Container = std::decay_t<decltype(source)>;
+		auto* storage = new Container(std::move(source));
+		stream->_storage = { storage, [](void* object) { delete static_cast<Container*>(object); } };
+		stream->_data = storage->data();
+		stream->_size = storage->size();
+		stream->_elementSize = sizeof(typename Container::value_type);
+	});
+	return stream;
+}
+
+ArrayStream* ArrayStream::Create(Producer producer, MonoClass* elementClass) {
+	auto* stream = new ArrayStream();
+	stream->_producer = producer;
+	stream->_elementClass = elementClass;
+	stream->_size = UnknownLength;
+	return stream;
+}
+
+size_t ArrayStream::Read(void* dest, size_t count) {
+	if (_producer) {
+		if (_size != UnknownLength || count == 0)
+			return 0;
+		// Producer fills the managed buffer directly, the end is fixed by the first empty chunk
+		auto produced = static_cast<size_t>(_producer(dest, _position, count));
+		produced = std::min(produced, count);
+		_position += produced;
+		if (produced == 0)
+			_size = _position;
+		return produced;
+	}
+
+	count = std::min(count, _size - _position);
+	const auto* source = static_cast<const uint8_t*>(_data) + _position * _elementSize;
+	if (_type == ValueType::ArrayChar8) {
+		ArrayKernels::WidenChar8(reinterpret_cast<const char*>(source), static_cast<char16_t*>(dest), count);
+	} else {
+		std::memcpy(dest, source, count * _elementSize);
+	}
+	_position += count;
+	return count;
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <plugify/value_type.h>
+
+extern "C" {
+	typedef struct _MonoClass MonoClass;
+}
+
+namespace monolm {
+	/// Native std::vector<T> or std::string passed by reference, target of managed NativeVector<T>.
+	/// Lives in the call arena, so it is valid only for the duration of the call.
+	struct ContainerRef {
+		void* container;
+		plugify::ValueType type;
+	};
+
+	/// Type erased access to native containers which back managed views.
+	class NativeContainer {
+	public:
+		NativeContainer() = delete;
+
+		/// Bytes of one element in native storage, 0 if the container has no contiguous storage of plain values.
+		static size_t GetElementSize(plugify::ValueType type);
+
+		static void* GetData(const ContainerRef& ref);
+		static size_t GetSize(const ContainerRef& ref);
+		static void Resize(const ContainerRef& ref, size_t size);
+		static void Append(const ContainerRef& ref, const void* element);
+	};
+
+	/// Native array read by managed NativeArrayStream, which copies it out in chunks into
+	/// a reused buffer instead of allocating one managed array of the full size.
+	/// Either takes over a vector returned by an import, or pulls elements from a native producer on demand.
+	class ArrayStream {
+	public:
+		/// Writes up to capacity elements starting at element offset into buffer, returns the number written, 0 at the end.
+		using Producer = uint64_t(*)(void* buffer, uint64_t offset, uint64_t capacity);
+
+		/// Length of a producer stream, which is not known until the producer reports the end.
+		static constexpr size_t UnknownLength = std::numeric_limits<size_t>::max();
+
+		static bool IsSupported(plugify::ValueType type);
+		/// Takes over contents of std::vector of the given array type, elementClass is the only accepted managed element.
+		static ArrayStream* Create(plugify::ValueType type, void* container, MonoClass* elementClass);
+		/// Producer writes elements in managed layout of elementClass, so native memory never holds more than one chunk.
+		static ArrayStream* Create(Producer producer, MonoClass* elementClass);
+
+		size_t GetLength() const { return _size; }
+		size_t GetPosition() const { return _position; }
+		/// char is widened to UTF-16 on managed side (System.Char), other elements are copied as is.
+		MonoClass* GetElementClass() const { return _elementClass; }
+
+		/// Copies up to count next elements in managed layout, returns the number of copied ones.
+		size_t Read(void* dest, size_t count);
+
+	private:
+		ArrayStream() = default;
+
+	private:
+		std::unique_ptr<void, void(*)(void*)> _storage{ nullptr, nullptr };
+		const void* _data{ nullptr };
+		Producer _producer{ nullptr };
+		size_t _size{ 0 };
+		size_t _position{ 0 };
+		size_t _elementSize{ 0 };
+		plugify::ValueType _type{};
+		MonoClass* _elementClass{ nullptr };
+	};
+}
\ No newline at end of file
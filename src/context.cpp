@@ -0,0 +1,58 @@
+#include "context.h"
+
+#include <mono/metadata/appdomain.h>
+#include <mono/metadata/threads.h>
+
+using namespace monolm;
+
+CallContext::CallContext() {
+	DCCallVM* vm = dcNewCallVM(4096);
+	dcMode(vm, DC_CALL_C_DEFAULT);
+	_vm = std::deleted_unique_ptr<DCCallVM>(vm, dcFree);
+
+	_aliveCount.fetch_add(1, std::memory_order_relaxed);
+	_createdCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+CallContext::~CallContext() {
+	_aliveCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+CallContext& CallContext::Get() {
+	thread_local CallContext context;
+	return context;
+}
+
+namespace monolm {
+	struct AttachedThread {
+		MonoThread* thread{ nullptr };
+
+		~AttachedThread() {
+			if (!thread)
+				return;
+			if (ThreadAttachment::_domain.load(std::memory_order_acquire))
+				mono_thread_detach(thread);
+			ThreadAttachment::_aliveCount.fetch_sub(1, std::memory_order_relaxed);
+		}
+	};
+}
+
+void ThreadAttachment::Attach() {
+	// Main thread and threads started by managed code are already known to the runtime
+	if (mono_domain_get()) {
+		_checked = true;
+		return;
+	}
+
+	MonoDomain* domain = _domain.load(std::memory_order_acquire);
+	if (!domain)
+		return;
+
+	_checked = true;
+
+	thread_local AttachedThread attached;
+	attached.thread = mono_thread_attach(domain);
+
+	_aliveCount.fetch_add(1, std::memory_order_relaxed);
+	_attachedCount.fetch_add(1, std::memory_order_relaxed);
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "arena.h"
+
+#include <dyncall/dyncall.h>
+
+extern "C" {
+	typedef struct _MonoDomain MonoDomain;
+}
+
+namespace monolm {
+	/// Per-thread state of the C# to C++ call path.
+	/// Created lazily on the first call made from a thread and freed when the thread exits,
+	/// so calls from different threads never share (or lock) a call VM.
+	class CallContext {
+	public:
+		CallContext();
+		~CallContext();
+		CallContext(const CallContext&) = delete;
+		CallContext& operator=(const CallContext&) = delete;
+
+		static CallContext& Get();
+
+		DCCallVM* GetVirtMachine() const { return _vm.get(); }
+		Arena& GetArena() { return _arena; }
+
+		static size_t GetAliveCount() { return _aliveCount.load(std::memory_order_relaxed); }
+		static size_t GetCreatedCount() { return _createdCount.load(std::memory_order_relaxed); }
+
+	private:
+		std::deleted_unique_ptr<DCCallVM> _vm;
+		Arena _arena;
+
+		static inline std::atomic<size_t> _aliveCount{ 0 };
+		static inline std::atomic<size_t> _createdCount{ 0 };
+	};
+
+	/// Attaches native threads to the mono runtime the first time they call into managed code,
+	/// threads attached here are detached again when they exit.
+	class ThreadAttachment {
+	public:
+		ThreadAttachment() = delete;
+
+		static void Ensure() {
+			if (!_checked) [[unlikely]]
+				Attach();
+		}
+
+		/// Domain new threads are attached to, reset on shutdown so late thread exits do not touch the runtime.
+		static void SetDomain(MonoDomain* domain) { _domain.store(domain, std::memory_order_release); }
+
+		static size_t GetAliveCount() { return _aliveCount.load(std::memory_order_relaxed); }
+		static size_t GetAttachedCount() { return _attachedCount.load(std::memory_order_relaxed); }
+
+	private:
+		static void Attach();
+
+		static inline thread_local bool _checked{ false };
+		static inline std::atomic<MonoDomain*> _domain{ nullptr };
+		static inline std::atomic<size_t> _aliveCount{ 0 };
+		static inline std::atomic<size_t> _attachedCount{ 0 };
+
+		friend struct AttachedThread;
+	};
+
+	/// Mutex which counts how many times a thread had to wait for another one.
+	class CountedMutex {
+	public:
+		void lock() {
+			if (!_mutex.try_lock()) {
+				_contentionCount.fetch_add(1, std::memory_order_relaxed);
+				_mutex.lock();
+			}
+		}
+		bool try_lock() { return _mutex.try_lock(); }
+		void unlock() { _mutex.unlock(); }
+
+		size_t GetContentionCount() const { return _contentionCount.load(std::memory_order_relaxed); }
+
+	private:
+		std::mutex _mutex;
+		std::atomic<size_t> _contentionCount{ 0 };
+	};
+}
\ No newline at end of file
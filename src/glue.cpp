@@ -1,9 +1,11 @@
 #include "glue.h"
 #include "module.h"
+#include "container.h"
 
 #include <plugify/plugify_provider.h>
 #include <plugify/plugin.h>
 
+#include <mono/metadata/class.h>
 #include <mono/metadata/object.h>
 
 using namespace monolm;
@@ -41,10 +43,57 @@ MonoString* Plugin_FindResource(MonoString* name, MonoString* path) {
 	return nullptr;
 }
 
+void* NativeVector_GetData(const ContainerRef* ref) {
+	return NativeContainer::GetData(*ref);
+}
+
+int32_t NativeVector_GetSize(const ContainerRef* ref) {
+	return static_cast<int32_t>(NativeContainer::GetSize(*ref));
+}
+
+void NativeVector_Resize(const ContainerRef* ref, int32_t size) {
+	NativeContainer::Resize(*ref, static_cast<size_t>(std::max(size, 0)));
+}
+
+void NativeVector_Append(const ContainerRef* ref, const void* element) {
+	NativeContainer::Append(*ref, element);
+}
+
+// -1 while a producer stream has not reached its end
+int64_t ArrayStream_GetLength(const ArrayStream* stream) {
+	return stream->GetLength() != ArrayStream::UnknownLength ? static_cast<int64_t>(stream->GetLength()) : -1;
+}
+
+int64_t ArrayStream_GetPosition(const ArrayStream* stream) {
+	return static_cast<int64_t>(stream->GetPosition());
+}
+
+// Bounds are checked on managed side, returns -1 if buffer element does not match the stream one
+int32_t ArrayStream_Read(ArrayStream* stream, MonoArray* buffer, int32_t offset, int32_t count) {
+	// Same size is not enough, i.e. float stream must not be read into int[]
+	MonoClass* arrayClass = mono_object_get_class(reinterpret_cast<MonoObject*>(buffer));
+	if (mono_class_get_element_class(arrayClass) != stream->GetElementClass())
+		return -1;
+	auto elementSize = mono_array_element_size(arrayClass);
+	return static_cast<int32_t>(stream->Read(mono_array_addr_with_size(buffer, elementSize, offset), static_cast<size_t>(count)));
+}
+
+void ArrayStream_Free(ArrayStream* stream) {
+	delete stream;
+}
+
 void Glue::RegisterFunctions() {
 	PLUG_ADD_INTERNAL_CALL(Core_GetBaseDirectory);
 	PLUG_ADD_INTERNAL_CALL(Core_IsModuleLoaded);
 	PLUG_ADD_INTERNAL_CALL(Core_IsPluginLoaded);
 	PLUG_ADD_INTERNAL_CALL(Plugin_FindPluginByName);
 	PLUG_ADD_INTERNAL_CALL(Plugin_FindResource);
+	PLUG_ADD_INTERNAL_CALL(NativeVector_GetData);
+	PLUG_ADD_INTERNAL_CALL(NativeVector_GetSize);
+	PLUG_ADD_INTERNAL_CALL(NativeVector_Resize);
+	PLUG_ADD_INTERNAL_CALL(NativeVector_Append);
+	PLUG_ADD_INTERNAL_CALL(ArrayStream_GetLength);
+	PLUG_ADD_INTERNAL_CALL(ArrayStream_GetPosition);
+	PLUG_ADD_INTERNAL_CALL(ArrayStream_Read);
+	PLUG_ADD_INTERNAL_CALL(ArrayStream_Free);
 }
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "intern.h"
+
+#include <mono/metadata/object.h>
+
+using namespace monolm;
+
+StringCache::StringCache(size_t capacity) : _capacity{capacity} {
+	_lookup.reserve(capacity);
+}
+
+StringCache::~StringCache() {
+	for (const auto& entry : _entries) {
+		mono_gchandle_free(entry.handle);
+	}
+}
+
+MonoString* StringCache::Find(std::string_view key) {
+	std::scoped_lock lock(_mutex);
+	auto it = _lookup.find(key);
+	if (it == _lookup.end()) {
+		_misses.fetch_add(1, std::memory_order_relaxed);
+		return nullptr;
+	}
+	_hits.fetch_add(1, std::memory_order_relaxed);
+	_entries.splice(_entries.begin(), _entries, std::get<EntryList::iterator>(*it));
+	return reinterpret_cast<MonoString*>(mono_gchandle_get_target(_entries.front().handle));
+}
+
+void StringCache::Insert(std::string_view key, MonoString* string) {
+	std::scoped_lock lock(_mutex);
+	if (_lookup.contains(key))
+		return;
+
+	if (_entries.size() >= _capacity) {
+		const auto& last = _entries.back();
+		_lookup.erase(last.key);
+		mono_gchandle_free(last.handle);
+		_entries.pop_back();
+		_evictions.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	_entries.emplace_front(std::string(key), mono_gchandle_new(reinterpret_cast<MonoObject*>(string), false));
+	_lookup.emplace(_entries.front().key, _entries.begin());
+}
\ No newline at end of file
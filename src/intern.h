@@ -0,0 +1,40 @@
+#pragma once
+
+extern "C" {
+	typedef struct _MonoString MonoString;
+}
+
+namespace monolm {
+	/// Bounded LRU cache of managed strings keyed by their UTF-8 bytes.
+	/// Every cached string is kept alive by a strong GC handle until it is evicted.
+	class StringCache {
+	public:
+		explicit StringCache(size_t capacity);
+		~StringCache();
+		StringCache(const StringCache&) = delete;
+		StringCache& operator=(const StringCache&) = delete;
+
+		MonoString* Find(std::string_view key);
+		void Insert(std::string_view key, MonoString* string);
+
+		size_t GetHits() const { return _hits.load(std::memory_order_relaxed); }
+		size_t GetMisses() const { return _misses.load(std::memory_order_relaxed); }
+		size_t GetEvictions() const { return _evictions.load(std::memory_order_relaxed); }
+
+	private:
+		struct Entry {
+			std::string key;
+			uint32_t handle;
+		};
+
+		using EntryList = std::list<Entry>;
+
+		size_t _capacity;
+		EntryList _entries; // most recently used first
+		std::unordered_map<std::string_view, EntryList::iterator> _lookup;
+		std::mutex _mutex;
+		std::atomic<size_t> _hits{ 0 };
+		std::atomic<size_t> _misses{ 0 };
+		std::atomic<size_t> _evictions{ 0 };
+	};
+}
\ No newline at end of file
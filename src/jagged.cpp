@@ -0,0 +1,134 @@
+#include "jagged.h"
+#include "module.h"
+#include "utf8.h"
+
+#include <mono/metadata/object.h>
+#include <mono/metadata/class.h>
+#include <mono/metadata/appdomain.h>
+
+using namespace monolm;
+
+namespace {
+	void Store(std::vector<uint8_t>& dest, size_t position, size_t value) {
+		auto element = static_cast<uint32_t>(value);
+		std::memcpy(dest.data() + position, &element, sizeof(element));
+	}
+
+	size_t Load(const std::vector<uint8_t>& source, size_t position) {
+		uint32_t element;
+		std::memcpy(&element, source.data() + position, sizeof(element));
+		return element;
+	}
+}
+
+bool JaggedArray::IsJagged(MonoArray* array) {
+	MonoClass* elementClass = mono_class_get_element_class(mono_object_get_class(reinterpret_cast<MonoObject*>(array)));
+	return mono_class_get_rank(elementClass) == 1;
+}
+
+MonoClass* JaggedArray::FindRowClass(std::string_view typeName) {
+	constexpr std::string_view suffix = "[][]";
+	if (!typeName.ends_with(suffix))
+		return nullptr;
+	std::string_view elementName = typeName.substr(0, typeName.size() - suffix.size());
+	size_t dot = elementName.rfind('.');
+	if (dot == std::string_view::npos)
+		return nullptr;
+	std::string nameSpace(elementName.substr(0, dot));
+	std::string name(elementName.substr(dot + 1));
+	MonoClass* elementClass = mono_class_from_name(mono_get_corlib(), nameSpace.c_str(), name.c_str());
+	if (!elementClass)
+		return nullptr;
+	return mono_array_class_get(elementClass, 1);
+}
+
+size_t JaggedArray::GetDataOffset(size_t rows, size_t stringOffsets) {
+	size_t header = sizeof(uint32_t) * (1 + rows + 1 + stringOffsets);
+	return (header + 7) & ~size_t{7};
+}
+
+void JaggedArray::Pack(MonoArray* source, std::vector<uint8_t>& dest) {
+	MonoClass* rowClass = mono_class_get_element_class(mono_object_get_class(reinterpret_cast<MonoObject*>(source)));
+	bool strings = mono_class_get_element_class(rowClass) == mono_get_string_class();
+
+	size_t rows = mono_array_length(source);
+	size_t total = 0;
+	for (size_t r = 0; r < rows; ++r) {
+		auto* row = mono_array_get(source, MonoArray*, r);
+		total += row ? mono_array_length(row) : 0;
+	}
+
+	size_t offset = GetDataOffset(rows, strings ? total + 1 : 0);
+	auto elementSize = static_cast<size_t>(mono_array_element_size(rowClass));
+	dest.resize(offset + (strings ? 0 : total * elementSize));
+	Store(dest, 0, rows);
+
+	// Row offsets first, then every row is copied as one block
+	size_t element = 0;
+	size_t stringOffsets = sizeof(uint32_t) * (rows + 2);
+	std::string scratch;
+	for (size_t r = 0; r < rows; ++r) {
+		Store(dest, sizeof(uint32_t) * (r + 1), element);
+		auto* row = mono_array_get(source, MonoArray*, r);
+		if (!row)
+			continue;
+		size_t length = mono_array_length(row);
+		if (strings) {
+			for (size_t i = 0; i < length; ++i) {
+				Store(dest, stringOffsets + sizeof(uint32_t) * (element + i), dest.size() - offset);
+				MonoStringToUTF8(mono_array_get(row, MonoString*, i), scratch);
+				dest.insert(dest.end(), scratch.begin(), scratch.end());
+			}
+		} else if (length) {
+			std::memcpy(dest.data() + offset + element * elementSize, mono_array_addr_with_size(row, static_cast<int>(elementSize), 0), length * elementSize);
+		}
+		element += length;
+	}
+	Store(dest, sizeof(uint32_t) * (rows + 1), element);
+	if (strings)
+		Store(dest, stringOffsets + sizeof(uint32_t) * element, dest.size() - offset);
+}
+
+MonoArray* JaggedArray::Unpack(const std::vector<uint8_t>& source, MonoClass* rowClass) {
+	MonoClass* elementClass = mono_class_get_element_class(rowClass);
+	bool strings = elementClass == mono_get_string_class();
+
+	size_t rows = source.size() >= sizeof(uint32_t) ? Load(source, 0) : 0;
+	if (sizeof(uint32_t) * (rows + 2) > source.size())
+		return g_monolm.CreateArray(rowClass, 0);
+
+	size_t total = Load(source, sizeof(uint32_t) * (rows + 1));
+	size_t offset = GetDataOffset(rows, strings ? total + 1 : 0);
+	auto elementSize = static_cast<size_t>(mono_class_array_element_size(elementClass));
+	if (offset > source.size() || (!strings && total * elementSize > source.size() - offset))
+		return g_monolm.CreateArray(rowClass, 0);
+
+	size_t stringOffsets = sizeof(uint32_t) * (rows + 2);
+	const auto* data = source.data() + offset;
+	size_t dataSize = source.size() - offset;
+
+	MonoArray* dest = g_monolm.CreateArray(rowClass, rows);
+	for (size_t r = 0; r < rows; ++r) {
+		size_t begin = Load(source, sizeof(uint32_t) * (r + 1));
+		size_t end = Load(source, sizeof(uint32_t) * (r + 2));
+		if (begin > end || end > total)
+			continue;
+
+		MonoArray* row = g_monolm.CreateArray(elementClass, end - begin);
+		if (strings) {
+			for (size_t i = begin; i < end; ++i) {
+				size_t first = Load(source, stringOffsets + sizeof(uint32_t) * i);
+				size_t last = Load(source, stringOffsets + sizeof(uint32_t) * (i + 1));
+				if (first > last || last > dataSize)
+					continue;
+				std::string_view element(reinterpret_cast<const char*>(data) + first, last - first);
+				mono_array_setref(row, i - begin, g_monolm.CreateInternedString(element));
+			}
+		} else if (end > begin) {
+			// Elements hold no references, so no write barrier is required
+			std::memcpy(mono_array_addr_with_size(row, static_cast<int>(elementSize), 0), data + begin * elementSize, (end - begin) * elementSize);
+		}
+		mono_array_setref(dest, r, row);
+	}
+	return dest;
+}
\ No newline at end of file
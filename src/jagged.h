@@ -0,0 +1,31 @@
+#pragma once
+
+extern "C" {
+	typedef struct _MonoArray MonoArray;
+	typedef struct _MonoClass MonoClass;
+}
+
+namespace monolm {
+	/// One level jagged array T[][] packed into std::vector<uint8_t>, so a whole table crosses the boundary at once:
+	///   uint32_t rows;
+	///   uint32_t rowOffsets[rows + 1];     // first element of every row, last entry is the total element count
+	///   uint32_t stringOffsets[total + 1]; // string[][] only, byte offset of every string in data
+	///   data, aligned to 8 bytes from the buffer start, elements laid out as in managed arrays
+	///   (bool is one byte, char is UTF-16), strings as UTF-8.
+	class JaggedArray {
+	public:
+		JaggedArray() = delete;
+
+		/// True if array elements are arrays themselves.
+		static bool IsJagged(MonoArray* array);
+		/// Row class of corlib jagged type name such as "System.Int32[][]", nullptr if it is not one.
+		static MonoClass* FindRowClass(std::string_view typeName);
+
+		static void Pack(MonoArray* source, std::vector<uint8_t>& dest);
+		/// rowClass is the class of one row (i.e. int[]), malformed rows are left null.
+		static MonoArray* Unpack(const std::vector<uint8_t>& source, MonoClass* rowClass);
+
+	private:
+		static size_t GetDataOffset(size_t rows, size_t stringOffsets);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define MONOLM_ARCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define MONOLM_TARGET_AVX2
+#else
+#define MONOLM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#else
+#define MONOLM_ARCH_X86 0
+#endif
+
+using namespace monolm;
+
+namespace {
+	using NarrowFunc = void(*)(const char16_t*, char*, size_t);
+	using WidenFunc = void(*)(const char*, char16_t*, size_t);
+	using FindWideFunc = size_t(*)(const char16_t*, size_t);
+	using FindFunc = size_t(*)(const char*, size_t);
+
+	void NarrowScalar(const char16_t* source, char* dest, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			dest[i] = static_cast<char>(source[i]);
+		}
+	}
+
+	void WidenScalar(const char* source, char16_t* dest, size_t count) {
+		for (size_t i = 0; i < count; ++i) {
+			dest[i] = static_cast<char16_t>(source[i]);
+		}
+	}
+
+	size_t FindNonAsciiScalar(const char16_t* source, size_t count) {
+		size_t i = 0;
+		while (i < count && source[i] < 0x80) {
+			++i;
+		}
+		return i;
+	}
+
+	size_t FindNonAsciiScalar(const char* source, size_t count) {
+		size_t i = 0;
+		while (i < count && static_cast<uint8_t>(source[i]) < 0x80) {
+			++i;
+		}
+		return i;
+	}
+
+#if MONOLM_ARCH_X86
+	void NarrowSSE2(const char16_t* source, char* dest, size_t count) {
+		const __m128i mask = _mm_set1_epi16(0x00FF);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			__m128i lo = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i)), mask);
+			__m128i hi = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + 8)), mask);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(lo, hi));
+		}
+		NarrowScalar(source + i, dest + i, count - i);
+	}
+
+	void WidenSSE2(const char* source, char16_t* dest, size_t count) {
+		const __m128i zero = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			__m128i high = std::is_signed_v<char> ? _mm_cmpgt_epi8(zero, bytes) : zero;
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_unpacklo_epi8(bytes, high));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8), _mm_unpackhi_epi8(bytes, high));
+		}
+		WidenScalar(source + i, dest + i, count - i);
+	}
+
+	size_t FindNonAsciiSSE2(const char16_t* source, size_t count) {
+		const __m128i mask = _mm_set1_epi16(static_cast<short>(0xFF80));
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8) {
+			__m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(chars, mask), _mm_setzero_si128())) != 0xFFFF)
+				break;
+		}
+		return i + FindNonAsciiScalar(source + i, count - i);
+	}
+
+	size_t FindNonAsciiSSE2(const char* source, size_t count) {
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			if (_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i))) != 0)
+				break;
+		}
+		return i + FindNonAsciiScalar(source + i, count - i);
+	}
+
+	MONOLM_TARGET_AVX2 void NarrowAVX2(const char16_t* source, char* dest, size_t count) {
+		const __m256i mask = _mm256_set1_epi16(0x00FF);
+		size_t i = 0;
+		for (; i + 32 <= count; i += 32) {
+			__m256i lo = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i)), mask);
+			__m256i hi = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i + 16)), mask);
+			// packus works per 128-bit lane, restore element order afterwards
+			__m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+		}
+		NarrowSSE2(source + i, dest + i, count - i);
+	}
+
+	MONOLM_TARGET_AVX2 void WidenAVX2(const char* source, char16_t* dest, size_t count) {
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+			__m256i words = std::is_signed_v<char> ? _mm256_cvtepi8_epi16(bytes) : _mm256_cvtepu8_epi16(bytes);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), words);
+		}
+		WidenScalar(source + i, dest + i, count - i);
+	}
+
+	MONOLM_TARGET_AVX2 size_t FindNonAsciiAVX2(const char16_t* source, size_t count) {
+		const __m256i mask = _mm256_set1_epi16(static_cast<short>(0xFF80));
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16) {
+			__m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i));
+			if (!_mm256_testz_si256(chars, mask))
+				break;
+		}
+		return i + FindNonAsciiSSE2(source + i, count - i);
+	}
+
+	MONOLM_TARGET_AVX2 size_t FindNonAsciiAVX2(const char* source, size_t count) {
+		size_t i = 0;
+		for (; i + 32 <= count; i += 32) {
+			if (_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + i))) != 0)
+				break;
+		}
+		return i + FindNonAsciiSSE2(source + i, count - i);
+	}
+
+	bool HasAVX2() {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!osxsave || (_xgetbv(0) & 0x6) != 0x6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+
+	struct Dispatch {
+		NarrowFunc narrow;
+		WidenFunc widen;
+		FindWideFunc findWide;
+		FindFunc find;
+		const char* target;
+	};
+
+	const Dispatch& GetDispatch() {
+		static const Dispatch dispatch = [] {
+#if MONOLM_ARCH_X86
+			if (HasAVX2())
+				return Dispatch{ &NarrowAVX2, &WidenAVX2, &FindNonAsciiAVX2, &FindNonAsciiAVX2, "avx2" };
+			return Dispatch{ &NarrowSSE2, &WidenSSE2, &FindNonAsciiSSE2, &FindNonAsciiSSE2, "sse2" };
+#else
+			return Dispatch{ &NarrowScalar, &WidenScalar, &FindNonAsciiScalar, &FindNonAsciiScalar, "scalar" };
+#endif
+		}();
+		return dispatch;
+	}
+}
+
+void ArrayKernels::NarrowChar16(const char16_t* source, char* dest, size_t count) {
+	GetDispatch().narrow(source, dest, count);
+}
+
+void ArrayKernels::WidenChar8(const char* source, char16_t* dest, size_t count) {
+	GetDispatch().widen(source, dest, count);
+}
+
+// std::vector<bool> exposes no storage, so bits are set one by one through the public interface
+void ArrayKernels::PackBool(const uint8_t* source, std::vector<bool>& dest, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		dest[i] = source[i] != 0;
+	}
+}
+
+void ArrayKernels::UnpackBool(const std::vector<bool>& source, uint8_t* dest) {
+	std::copy(source.begin(), source.end(), dest);
+}
+
+size_t ArrayKernels::FindNonAscii(const char16_t* source, size_t count) {
+	return GetDispatch().findWide(source, count);
+}
+
+size_t ArrayKernels::FindNonAscii(const char* source, size_t count) {
+	return GetDispatch().find(source, count);
+}
+
+const char* ArrayKernels::GetTarget() {
+	return GetDispatch().target;
+}
\ No newline at end of file
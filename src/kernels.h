@@ -0,0 +1,27 @@
+#pragma once
+
+namespace monolm {
+	/// Bulk conversion kernels for moving array contents between managed and native storage.
+	/// The best implementation (AVX2, SSE2 or scalar) is selected once at runtime.
+	class ArrayKernels {
+	public:
+		ArrayKernels() = delete;
+
+		/// char16_t -> char, truncates every element like static_cast<char> does.
+		static void NarrowChar16(const char16_t* source, char* dest, size_t count);
+		/// char -> char16_t, extends every element like static_cast<char16_t> does.
+		static void WidenChar8(const char* source, char16_t* dest, size_t count);
+
+		/// Managed bool[] (one byte per element) -> std::vector<bool>, dest must be resized to count.
+		/// Both bool conversions are scalar, packed storage of std::vector<bool> is not portably accessible.
+		static void PackBool(const uint8_t* source, std::vector<bool>& dest, size_t count);
+		/// std::vector<bool> -> managed bool[] (one byte per element).
+		static void UnpackBool(const std::vector<bool>& source, uint8_t* dest);
+
+		/// Returns the index of the first element outside of ASCII range, or count if all are ASCII.
+		static size_t FindNonAscii(const char16_t* source, size_t count);
+		static size_t FindNonAscii(const char* source, size_t count);
+
+		static const char* GetTarget();
+	};
+}
\ No newline at end of file
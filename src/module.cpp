@@ -1,5 +1,9 @@
 #include "module.h"
+#include "container.h"
+#include "jagged.h"
 #include "glue.h"
+#include "kernels.h"
+#include "utf8.h"
 #include "utils.h"
 
 #include <mono/jit/jit.h>
@@ -12,6 +16,7 @@
 #include <mono/metadata/mono-config.h>
 #include <mono/metadata/threads.h>
 #include <mono/metadata/exception.h>
+#include <mono/metadata/reflection.h>
 
 #include <plugify/module.h>
 #include <plugify/plugin.h>
@@ -54,44 +59,182 @@ bool IsMethodPrimitive(const plugify::Method& method) {
 		return false;
 
 	for (const auto& param : method.paramTypes) {
-		if (param.type == ValueType::Char8 || (param.type >= ValueType::LastPrimitive && method.retType.type < ValueType::FirstPOD))
+		if (param.type == ValueType::Char8 || (param.type >= ValueType::LastPrimitive && param.type < ValueType::FirstPOD))
 			return false;
 	}
 
 	return true;
 }
 
+// Internal call can point straight at native export: managed and native representation
+// of every parameter and the return are the same, so no conversion is needed in between
+bool IsMethodDirect(const plugify::Method& method) {
+	auto isDirect = [](const Property& property) {
+		switch (property.type) {
+			case ValueType::Bool:
+			case ValueType::Char16:
+			case ValueType::Int8:
+			case ValueType::Int16:
+			case ValueType::Int32:
+			case ValueType::Int64:
+			case ValueType::UInt8:
+			case ValueType::UInt16:
+			case ValueType::UInt32:
+			case ValueType::UInt64:
+			case ValueType::Pointer:
+			case ValueType::Float:
+			case ValueType::Double:
+				return true;
+			case ValueType::Vector2:
+			case ValueType::Vector3:
+			case ValueType::Vector4:
+			case ValueType::Matrix4x4:
+				// Native side takes aggregates by pointer, managed passes them by value unless ref
+				return property.ref;
+			default:
+				// Char8 differs in width, delegates, strings and arrays need conversion
+				return false;
+		}
+	};
+
+	// Aggregate returns follow platform specific conventions, leave them to ExternalCall
+	if (method.retType.type != ValueType::Void && (method.retType.ref || method.retType.type >= ValueType::FirstPOD || !isDirect(method.retType)))
+		return false;
+
+	return std::all_of(method.paramTypes.begin(), method.paramTypes.end(), isDirect);
+}
+
 std::string monolm::MonoStringToUTF8(MonoString* string) {
-	if (string == nullptr || mono_string_length(string) == 0)
-		return {};
-	MonoError error;
-	char* utf8 = mono_string_to_utf8_checked(string, &error);
-	if (!mono_error_ok(&error)) {
-		g_monolm.GetProvider()->Log(std::format(LOG_PREFIX "Failed to convert MonoString* to UTF-8: ({}) {}.", mono_error_get_error_code(&error), mono_error_get_message(&error)), Severity::Debug);
-		mono_error_cleanup(&error);
-		return {};
-	}
-	std::string result(utf8);
-	mono_free(utf8);
+	std::string result;
+	MonoStringToUTF8(string, result);
 	return result;
 }
 
+void monolm::MonoStringToUTF8(MonoString* string, std::string& dest) {
+	if (string == nullptr) {
+		dest.clear();
+		return;
+	}
+	auto* chars = reinterpret_cast<const char16_t*>(mono_string_chars(string));
+	Utf8::FromUtf16(chars, static_cast<size_t>(mono_string_length(string)), dest);
+}
+
+bool monolm::MonoStringEquals(MonoString* string, std::string_view source) {
+	if (string == nullptr)
+		return source.empty();
+	auto* chars = reinterpret_cast<const char16_t*>(mono_string_chars(string));
+	return Utf8::Equals(chars, static_cast<size_t>(mono_string_length(string)), source.data(), source.size());
+}
+
+// Float arrays can be backed by Vector2/3/4 or Matrix4x4 arrays on managed side, their layouts match
+template<typename T>
+size_t GetArrayLength(MonoArray* array) {
+	size_t length = mono_array_length(array);
+	if constexpr (std::is_same_v<T, float>) {
+		auto elementSize = static_cast<size_t>(mono_array_element_size(mono_object_get_class(reinterpret_cast<MonoObject*>(array))));
+		return length * elementSize / sizeof(float);
+	}
+	return length;
+}
+
 template<typename T>
 void monolm::MonoArrayToVector(MonoArray* array, std::vector<T>& dest) {
-	auto length = mono_array_length(array);
+	if (array == nullptr) {
+		dest.clear();
+		return;
+	}
+	if constexpr (std::is_same_v<T, uint8_t>) {
+		// Byte arrays also carry packed jagged arrays
+		if (JaggedArray::IsJagged(array)) {
+			JaggedArray::Pack(array, dest);
+			return;
+		}
+	}
+	auto length = GetArrayLength<T>(array);
 	dest.resize(length);
-	for (size_t i = 0; i < length; ++i) {
-		if constexpr (std::is_same_v<T, std::string>) {
+	if (length == 0)
+		return;
+	if constexpr (std::is_same_v<T, std::string>) {
+		for (size_t i = 0; i < length; ++i) {
 			MonoObject* element = mono_array_get(array, MonoObject*, i);
-			if (element != nullptr)
-				dest[i] = MonoStringToUTF8(reinterpret_cast<MonoString*>(element));
-			else
-				dest[i] = T{};
-		} else if constexpr (std::is_same_v<T, char>) {
-			dest[i] = static_cast<char>(mono_array_get(array, char16_t, i));
-		} else {
-			dest[i] = mono_array_get(array, T, i);
+			MonoStringToUTF8(reinterpret_cast<MonoString*>(element), dest[i]);
+		}
+	} else if constexpr (std::is_same_v<T, char>) {
+		ArrayKernels::NarrowChar16(mono_array_addr(array, char16_t, 0), dest.data(), length);
+	} else if constexpr (std::is_same_v<T, bool>) {
+		ArrayKernels::PackBool(mono_array_addr(array, uint8_t, 0), dest, length);
+	} else {
+		// Blittable, copy managed storage as is
+		std::memcpy(dest.data(), mono_array_addr(array, T, 0), length * sizeof(T));
+	}
+}
+
+template<typename T>
+void monolm::VectorToMonoArray(const std::vector<T>& source, MonoArray* array) {
+	if (source.empty())
+		return;
+	if constexpr (std::is_same_v<T, char>) {
+		ArrayKernels::WidenChar8(source.data(), mono_array_addr(array, char16_t, 0), source.size());
+	} else if constexpr (std::is_same_v<T, bool>) {
+		ArrayKernels::UnpackBool(source, mono_array_addr(array, uint8_t, 0));
+	} else {
+		// Elements hold no references, so no write barrier is required
+		std::memcpy(mono_array_addr(array, T, 0), source.data(), source.size() * sizeof(T));
+	}
+}
+
+template<typename T>
+bool monolm::MonoArrayEquals(MonoArray* array, const std::vector<T>& source) {
+	if (array == nullptr || GetArrayLength<T>(array) != source.size())
+		return false;
+	if constexpr (std::is_same_v<T, std::string>) {
+		for (size_t i = 0; i < source.size(); ++i) {
+			if (!MonoStringEquals(mono_array_get(array, MonoString*, i), source[i]))
+				return false;
+		}
+	} else if constexpr (std::is_same_v<T, char>) {
+		// Narrowed in chunks by the same kernel which writes them back, then compared as bytes
+		std::array<char, 256> chunk;
+		const auto* chars = mono_array_addr(array, char16_t, 0);
+		for (size_t i = 0; i < source.size(); i += chunk.size()) {
+			size_t count = std::min(chunk.size(), source.size() - i);
+			ArrayKernels::NarrowChar16(chars + i, chunk.data(), count);
+			if (std::memcmp(chunk.data(), source.data() + i, count) != 0)
+				return false;
+		}
+	} else if constexpr (std::is_same_v<T, bool>) {
+		const auto* bytes = mono_array_addr(array, uint8_t, 0);
+		for (size_t i = 0; i < source.size(); ++i) {
+			if ((bytes[i] != 0) != source[i])
+				return false;
 		}
+	} else {
+		return source.empty() || std::memcmp(mono_array_addr(array, T, 0), source.data(), source.size() * sizeof(T)) == 0;
+	}
+	return true;
+}
+
+template<typename T>
+void MonoArrayToBuffer(MonoArray* array, OutputBuffer& buffer) {
+	if constexpr (std::is_same_v<T, uint8_t>) {
+		if (array && JaggedArray::IsJagged(array)) {
+			thread_local std::vector<uint8_t> scratch;
+			JaggedArray::Pack(array, scratch);
+			buffer.size = scratch.size();
+			std::memcpy(buffer.data, scratch.data(), std::min(scratch.size(), buffer.capacity));
+			return;
+		}
+	}
+	size_t length = array ? GetArrayLength<T>(array) : 0;
+	buffer.size = length;
+	size_t count = std::min(length, buffer.capacity);
+	if (count == 0)
+		return;
+	if constexpr (std::is_same_v<T, char>) {
+		ArrayKernels::NarrowChar16(mono_array_addr(array, char16_t, 0), static_cast<char*>(buffer.data), count);
+	} else {
+		// Managed bool is single byte as well, so it is copied as is
+		std::memcpy(buffer.data, mono_array_addr(array, T, 0), count * sizeof(T));
 	}
 }
 
@@ -205,6 +348,33 @@ ValueType MonoTypeToValueType(const char* typeName) {
 			{ "System.Numerics.Vector3&", ValueType::Vector3 },
 			{ "System.Numerics.Vector4&", ValueType::Vector4 },
 			{ "System.Numerics.Matrix4x4&", ValueType::Matrix4x4 },
+
+			// Passed as flat float arrays on native side
+			{ "System.Numerics.Vector2[]", ValueType::ArrayFloat },
+			{ "System.Numerics.Vector3[]", ValueType::ArrayFloat },
+			{ "System.Numerics.Vector4[]", ValueType::ArrayFloat },
+			{ "System.Numerics.Matrix4x4[]", ValueType::ArrayFloat },
+
+			{ "System.Numerics.Vector2[]&", ValueType::ArrayFloat },
+			{ "System.Numerics.Vector3[]&", ValueType::ArrayFloat },
+			{ "System.Numerics.Vector4[]&", ValueType::ArrayFloat },
+			{ "System.Numerics.Matrix4x4[]&", ValueType::ArrayFloat },
+
+			// One level jagged arrays, packed into bytes on native side
+			{ "System.Boolean[][]", ValueType::ArrayUInt8 },
+			{ "System.Char[][]", ValueType::ArrayUInt8 },
+			{ "System.SByte[][]", ValueType::ArrayUInt8 },
+			{ "System.Int16[][]", ValueType::ArrayUInt8 },
+			{ "System.Int32[][]", ValueType::ArrayUInt8 },
+			{ "System.Int64[][]", ValueType::ArrayUInt8 },
+			{ "System.Byte[][]", ValueType::ArrayUInt8 },
+			{ "System.UInt16[][]", ValueType::ArrayUInt8 },
+			{ "System.UInt32[][]", ValueType::ArrayUInt8 },
+			{ "System.UInt64[][]", ValueType::ArrayUInt8 },
+			{ "System.IntPtr[][]", ValueType::ArrayUInt8 },
+			{ "System.Single[][]", ValueType::ArrayUInt8 },
+			{ "System.Double[][]", ValueType::ArrayUInt8 },
+			{ "System.String[][]", ValueType::ArrayUInt8 },
 	};
 	auto it = valueTypeMap.find(typeName);
 	if (it != valueTypeMap.end())
@@ -284,23 +454,45 @@ ClassInfo LoadCoreClass(std::vector<std::string>& errors, MonoImage* image, cons
 	return { klass, ctor };
 }
 
+// Raw storage for hidden return, callee constructs a new container in it which is destroyed on rewind.
+// Its heap buffer cannot come from a pool since callee does not assign into an existing object,
+// GetMethodInto form is the allocation free alternative.
 template<typename T>
-void* AllocateMemory(ArgumentList& args) {
-	void* ptr = malloc(sizeof(T));
+void* AllocateMemory(Arena& arena, ArgumentList& args) {
+	void* ptr = arena.Allocate<T>();
 	args.push_back(ptr);
 	return ptr;
 }
 
+// Keeps managed array at a fixed address until the end of the call
+class PinnedHandle {
+public:
+	explicit PinnedHandle(MonoObject* object) : _handle{mono_gchandle_new(object, true)} {}
+	~PinnedHandle() { mono_gchandle_free(_handle); }
+	PinnedHandle(const PinnedHandle&) = delete;
+	PinnedHandle& operator=(const PinnedHandle&) = delete;
+
+private:
+	uint32_t _handle;
+};
+
+// Ref cell passed to managed code, second element keeps the original object to detect changes
 template<typename T>
-void FreeMemory(void* ptr) {
-	reinterpret_cast<T*>(ptr)->~T();
-	free(ptr);
+T** NewRefCell(Arena& arena, T* object) {
+	auto** cell = static_cast<T**>(arena.Allocate(sizeof(T*) * 2, alignof(T*)));
+	cell[0] = object;
+	cell[1] = object;
+	return cell;
 }
 
 void FunctionRefQueueCallback(void* function) {
 	delete reinterpret_cast<Function*>(function);
 }
 
+void ImportRefQueueCallback(void* import) {
+	delete reinterpret_cast<ImportMethod*>(import);
+}
+
 InitResult CSharpLanguageModule::Initialize(std::weak_ptr<IPlugifyProvider> provider, const IModule& module) {
 	if (!(_provider = provider.lock()))
 		return ErrorData{ "Provider not exposed" };
@@ -326,6 +518,8 @@ InitResult CSharpLanguageModule::Initialize(std::weak_ptr<IPlugifyProvider> prov
 	Glue::RegisterFunctions();
 
 	_rt = std::make_shared<asmjit::JitRuntime>();
+	_provider->Log(std::format(LOG_PREFIX "Array kernels: {}", ArrayKernels::GetTarget()), Severity::Debug);
+	_aggregates = std::make_unique<AggregateRegistry>();
 
 	// Create an app domain
 	char appName[] = "PlugifyMonoRuntime";
@@ -335,6 +529,10 @@ InitResult CSharpLanguageModule::Initialize(std::weak_ptr<IPlugifyProvider> prov
 
 	mono_domain_set(appDomain, true);
 	_appDomain = std::deleted_unique_ptr<MonoDomain>(appDomain, mono_domain_unload);
+	ThreadAttachment::SetDomain(appDomain);
+
+	if (_settings.stringCacheSize > 0)
+		_stringCache = std::make_unique<StringCache>(_settings.stringCacheSize);
 
 	std::vector<std::string> assemblyErrors;
 
@@ -354,6 +552,42 @@ InitResult CSharpLanguageModule::Initialize(std::weak_ptr<IPlugifyProvider> prov
 
 	{
 		_plugin = LoadCoreClass(assemblyErrors, _core.image, "Plugin", 9);
+
+		MonoClass* dispatcher = mono_class_from_name(_core.image, "Plugify", "Dispatcher");
+		if (dispatcher) {
+			_setUpdateTargets = mono_class_get_method_from_name(dispatcher, "SetUpdateTargets", 1);
+			_createBatch = mono_class_get_method_from_name(dispatcher, "CreateBatch", 2);
+			MonoMethod* update = mono_class_get_method_from_name(dispatcher, "Update", 1);
+			MonoMethod* invokeBatch = mono_class_get_method_from_name(dispatcher, "InvokeBatch", 5);
+			if (!_setUpdateTargets || !_createBatch || !update || !invokeBatch) {
+				assemblyErrors.emplace_back("Dispatcher methods");
+			} else {
+				_update = reinterpret_cast<UpdateThunk>(mono_method_get_unmanaged_thunk(update));
+				_invokeBatch = reinterpret_cast<InvokeBatchThunk>(mono_method_get_unmanaged_thunk(invokeBatch));
+			}
+
+			mono_add_internal_call("Plugify.InternalCalls::Batch_Invoke", reinterpret_cast<const void*>(&InvokeBatch));
+			mono_add_internal_call("Plugify.InternalCalls::ArrayStream_Open", reinterpret_cast<const void*>(&OpenArrayStream));
+		} else {
+			assemblyErrors.emplace_back("Dispatcher");
+		}
+		_stringList = mono_class_from_name(_core.image, "Plugify", "NativeStringList");
+		if (_stringList) {
+			_stringListData = mono_class_get_field_from_name(_stringList, "_data");
+			_stringListOffsets = mono_class_get_field_from_name(_stringList, "_offsets");
+			if (!_stringListData || !_stringListOffsets)
+				assemblyErrors.emplace_back("NativeStringList fields");
+		} else {
+			assemblyErrors.emplace_back("NativeStringList");
+		}
+		_arrayStream = mono_class_from_name(_core.image, "Plugify", "NativeArrayStream");
+		if (_arrayStream) {
+			_arrayStreamHandle = mono_class_get_field_from_name(_arrayStream, "_stream");
+			if (!_arrayStreamHandle)
+				assemblyErrors.emplace_back("NativeArrayStream fields");
+		} else {
+			assemblyErrors.emplace_back("NativeArrayStream");
+		}
 		//_vector2 = LoadCoreClass(assemblyErrors, _core.image, "Vector2", 2);
 		//_vector3 = LoadCoreClass(assemblyErrors, _core.image, "Vector3", 3);
 		//_vector4 = LoadCoreClass(assemblyErrors, _core.image, "Vector4", 4);
@@ -408,16 +642,13 @@ InitResult CSharpLanguageModule::Initialize(std::weak_ptr<IPlugifyProvider> prov
 	_provider->Log("Loaded dependency assemblies and classes", Severity::Debug);
 
 	_functionReferenceQueue = std::deleted_unique_ptr<MonoReferenceQueue>(mono_gc_reference_queue_new(FunctionRefQueueCallback), mono_gc_reference_queue_free);
+	_importReferenceQueue = std::deleted_unique_ptr<MonoReferenceQueue>(mono_gc_reference_queue_new(ImportRefQueueCallback), mono_gc_reference_queue_free);
 
 	// MonoAssemblyName is an incomplete type (internal to mono), so we can't allocate it ourselves.
 	// There isn't any api to allocate an empty one either, so we need to do it this way.
 	_assemblyName = std::deleted_unique_ptr<MonoAssemblyName>(mono_assembly_name_new("blank"), mono_free);
 	mono_assembly_name_free(_assemblyName.get()); // "it does not frees the object itself, only the name members" (typo included)
 
-	DCCallVM* vm = dcNewCallVM(4096);
-	dcMode(vm, DC_CALL_C_DEFAULT);
-	_callVirtMachine = std::deleted_unique_ptr<DCCallVM>(vm, dcFree);
-
 	_provider->Log(LOG_PREFIX "Inited!", Severity::Debug);
 
 	return InitResultData{};
@@ -425,20 +656,45 @@ InitResult CSharpLanguageModule::Initialize(std::weak_ptr<IPlugifyProvider> prov
 
 void CSharpLanguageModule::Shutdown() {
 	_provider->Log(LOG_PREFIX "Shutting down Mono runtime", Severity::Debug);
+	_provider->Log(std::format(LOG_PREFIX "Call contexts: {} created, {} alive, delegate cache contention: {}", CallContext::GetCreatedCount(), CallContext::GetAliveCount(), _delegateMutex.GetContentionCount()), Severity::Debug);
+	_provider->Log(std::format(LOG_PREFIX "Attached threads: {} total, {} alive", ThreadAttachment::GetAttachedCount(), ThreadAttachment::GetAliveCount()), Severity::Debug);
+	if (_stringCache)
+		_provider->Log(std::format(LOG_PREFIX "String cache: {} hits, {} misses, {} evictions", _stringCache->GetHits(), _stringCache->GetMisses(), _stringCache->GetEvictions()), Severity::Debug);
 
+	// Cached strings are held by strong handles, they must be freed before the domain is unloaded
+	_stringCache.reset();
 	_functionReferenceQueue.reset();
+	_importReferenceQueue.reset();
 	_assemblyName.reset();
 	_cachedDelegates.clear();
+	_startedScripts.clear();
+	_update = nullptr;
+	_setUpdateTargets = nullptr;
+	_invokeBatch = nullptr;
+	_createBatch = nullptr;
+	_stringList = nullptr;
+	_stringListData = nullptr;
+	_stringListOffsets = nullptr;
+	_arrayStream = nullptr;
+	_arrayStreamHandle = nullptr;
 	_funcClasses.clear();
 	_actionClasses.clear();
 	_importMethods.clear();
+	_batchMethods.clear();
+	_intoMethods.clear();
 	_exportMethods.clear();
+	_delegateInvokers.clear();
+	_structPlans.clear();
+	_structs.clear();
+	_plans.clear();
 	_functions.clear();
 	_methods.clear();
 	_scripts.clear();
-	_callVirtMachine.reset();
 	_rt.reset();
 
+	_aggregates.reset();
+
+	ThreadAttachment::SetDomain(nullptr);
 	ShutdownMono();
 	_provider.reset();
 }
@@ -529,15 +785,15 @@ void CSharpLanguageModule::ShutdownMono() {
 }
 
 template<typename T>
-void* CSharpLanguageModule::MonoStructToArg(ArgumentList& args) {
-	auto* dest = new T();
+void* CSharpLanguageModule::MonoStructToArg(Arena& arena, ArgumentList& args) {
+	auto* dest = arena.New<T>();
 	args.push_back(dest);
 	return dest;
 }
 
 template<typename T>
-void* CSharpLanguageModule::MonoArrayToArg(MonoArray* source, ArgumentList& args) {
-	auto* dest = new std::vector<T>();
+void* CSharpLanguageModule::MonoArrayToArg(MonoArray* source, Arena& arena, ArgumentList& args) {
+	auto* dest = arena.Acquire<std::vector<T>>();
 	if (source != nullptr) {
 		MonoArrayToVector(source, *dest);
 	}
@@ -545,21 +801,250 @@ void* CSharpLanguageModule::MonoArrayToArg(MonoArray* source, ArgumentList& args
 	return dest;
 }
 
-void* CSharpLanguageModule::MonoStringToArg(MonoString* source, ArgumentList& args) {
-	std::string* dest;
+void* CSharpLanguageModule::MonoArrayToView(MonoArray* source, size_t elementSize, Arena& arena, ArgumentList& args) {
+	auto* dest = arena.New<ArrayView<void>>(nullptr, 0);
 	if (source != nullptr) {
-		MonoError error;
-		char* cStr = mono_string_to_utf8_checked(source, &error);
-		if (!mono_error_ok(&error)) {
-			g_monolm.GetProvider()->Log(std::format(LOG_PREFIX "Failed to convert MonoString* to UTF-8: ({}) {}.", mono_error_get_error_code(&error), mono_error_get_message(&error)), Severity::Debug);
-			mono_error_cleanup(&error);
-			return {};
-		}
-		dest = new std::string(cStr);
-		mono_free(cStr);
+		arena.New<PinnedHandle>(reinterpret_cast<MonoObject*>(source));
+		auto sourceSize = static_cast<size_t>(mono_array_element_size(mono_object_get_class(reinterpret_cast<MonoObject*>(source))));
+		dest->data = mono_array_addr_with_size(source, static_cast<int>(elementSize), 0);
+		dest->size = mono_array_length(source) * sourceSize / elementSize;
+	}
+	args.push_back(dest);
+	return dest;
+}
+
+// Only arrays whose managed element layout matches the native one can be viewed
+size_t CSharpLanguageModule::GetArrayViewElementSize(ValueType type) {
+	switch (type) {
+		case ValueType::ArrayBool:
+		case ValueType::ArrayInt8:
+		case ValueType::ArrayUInt8:
+			return 1;
+		case ValueType::ArrayChar16:
+		case ValueType::ArrayInt16:
+		case ValueType::ArrayUInt16:
+			return 2;
+		case ValueType::ArrayInt32:
+		case ValueType::ArrayUInt32:
+		case ValueType::ArrayFloat:
+			return 4;
+		case ValueType::ArrayInt64:
+		case ValueType::ArrayUInt64:
+		case ValueType::ArrayDouble:
+			return 8;
+		case ValueType::ArrayPointer:
+			return sizeof(uintptr_t);
+		default:
+			return 0;
+	}
+}
+
+// User blittable struct, passed by pointer as is, arrays are copied as one block
+void* CSharpLanguageModule::NativeStructToArg(const MarshalOp& op, const Parameters* p, uint8_t i, Arena& arena) {
+	if (op.type == ValueType::ArrayUInt8) {
+		const auto& source = *p->GetArgument<std::vector<uint8_t>*>(i);
+		if (source.size() % op.stride != 0) {
+			// Partial trailing element would be silently dropped, managed side receives null instead
+			g_monolm._provider->Log(std::format(LOG_PREFIX "Struct array parameter {} has {} bytes, which is not a multiple of element size {}", op.index, source.size(), op.stride), Severity::Error);
+			return nullptr;
+		}
+		size_t count = source.size() / op.stride;
+		MonoArray* array = g_monolm.CreateArray(op.klass, count);
+		if (count)
+			std::memcpy(mono_array_addr_with_size(array, static_cast<int>(op.stride), 0), source.data(), count * op.stride);
+		return array;
+	}
+
+	void* source = p->GetArgument<void*>(i);
+	if (!source) {
+		// Value type parameter can not be null on managed side
+		source = arena.Allocate(op.stride, alignof(std::max_align_t));
+		std::memset(source, 0, op.stride);
+	}
+	return source;
+}
+
+// Managed view struct holds single pointer, so argument is the storage of that pointer,
+// string list is a regular object
+void* CSharpLanguageModule::NativeViewToArg(const MarshalOp& op, const Parameters* p, uint8_t i, Arena& arena) {
+	if (op.view == ViewKind::StringList)
+		return g_monolm.CreateStringList(*p->GetArgument<std::vector<std::string>*>(i));
+
+	ContainerRef ref{ p->GetArgument<void*>(i), op.type };
+	void* view;
+	if (op.view == ViewKind::Vector) {
+		view = arena.New<ContainerRef>(ref);
 	} else {
-		dest = new std::string();
+		view = arena.New<ArrayView<void>>(NativeContainer::GetData(ref), NativeContainer::GetSize(ref));
+	}
+	return arena.New<void*>(view);
+}
+
+ValueType CSharpLanguageModule::GetViewParamType(MonoType* type, const Property& param, MarshalOp& op, std::string& error) {
+	MonoClass* klass = mono_class_from_mono_type(type);
+	if (mono_class_get_image(klass) != _core.image)
+		return ValueType::Invalid;
+
+	std::string_view name = mono_class_get_name(klass);
+	if (name == "NativeStringList") {
+		if (mono_type_is_byref(type) || param.ref || param.type != ValueType::ArrayString) {
+			error = "NativeStringList can be used only for array of strings passed by value";
+			return ValueType::Invalid;
+		}
+		op.view = ViewKind::StringList;
+		op.size = 0;
+		return param.type;
+	}
+
+	bool string = name == "NativeString";
+	ViewKind view;
+	if (string || name == "NativeSpan`1")
+		view = ViewKind::Span;
+	else if (name == "NativeVector`1")
+		view = ViewKind::Vector;
+	else
+		return ValueType::Invalid;
+
+	if (mono_type_is_byref(type)) {
+		error = std::format("view '{}' should be passed by value", name);
+		return ValueType::Invalid;
+	}
+
+	if (param.ref != (view == ViewKind::Vector)) {
+		error = param.ref ? "parameter passed by reference can be viewed only by NativeVector<T>" : "NativeVector<T> can view only parameter passed by reference";
+		return ValueType::Invalid;
+	}
+
+	size_t nativeSize = NativeContainer::GetElementSize(param.type);
+	if (!nativeSize || (view == ViewKind::Span && string != (param.type == ValueType::String))) {
+		error = std::format("view '{}' can not be used for '{}'", name, ValueTypeToString(param.type));
+		return ValueType::Invalid;
+	}
+
+	if (!string) {
+		// Size of T is known only on managed side
+		MonoMethod* getElementSize = mono_class_get_method_from_name(klass, "GetElementSize", 0);
+		MonoObject* exception = nullptr;
+		MonoObject* result = getElementSize ? mono_runtime_invoke(getElementSize, nullptr, nullptr, &exception) : nullptr;
+		if (!result || exception) {
+			error = std::format("view '{}' element size is unknown", name);
+			return ValueType::Invalid;
+		}
+		auto managedSize = static_cast<size_t>(*reinterpret_cast<int32_t*>(mono_object_unbox(result)));
+		if (managedSize != nativeSize) {
+			error = std::format("view '{}' has element of {} bytes when native one has {}", name, managedSize, nativeSize);
+			return ValueType::Invalid;
+		}
+	}
+
+	op.view = view;
+	op.size = sizeof(void*);
+	return param.type;
+}
+
+ValueType CSharpLanguageModule::GetStructParamType(MonoType* type, const Property& param, MarshalOp& op, std::string& error) {
+	bool array = mono_type_get_type(type) == MONO_TYPE_SZARRAY;
+	MonoClass* klass = mono_class_from_mono_type(type);
+	if (array)
+		klass = mono_class_get_element_class(klass);
+
+	if (!mono_class_is_valuetype(klass) || !_settings.structs.contains(std::format("{}.{}", mono_class_get_namespace(klass), mono_class_get_name(klass))))
+		return ValueType::Invalid;
+
+	if (param.ref || (array && mono_type_is_byref(type))) {
+		error = "user structs can not be passed by reference from native side";
+		return ValueType::Invalid;
+	}
+
+	uint32_t size = VerifyStruct(klass, error);
+	if (!size)
+		return ValueType::Invalid;
+
+	// Native side passes struct by pointer, arrays of structs as raw bytes
+	op.stride = size;
+	op.size = 0;
+	if (array)
+		op.klass = klass;
+	return array ? ValueType::ArrayUInt8 : ValueType::Pointer;
+}
+
+uint32_t CSharpLanguageModule::VerifyStruct(MonoClass* klass, std::string& error) {
+	auto it = _structs.find(klass);
+	if (it != _structs.end())
+		return std::get<uint32_t>(*it);
+
+	std::string name = std::format("{}.{}", mono_class_get_namespace(klass), mono_class_get_name(klass));
+	const StructLayout& layout = _settings.structs.at(name);
+
+	uint32_t layoutFlags = mono_class_get_flags(klass) & MONO_TYPE_ATTR_LAYOUT_MASK;
+	if (layoutFlags == MONO_TYPE_ATTR_AUTO_LAYOUT) {
+		error = std::format("struct '{}' has auto layout, use sequential or explicit", name);
+		return 0;
+	}
+
+	auto size = static_cast<uint32_t>(mono_class_value_size(klass, nullptr));
+	if (size != layout.size) {
+		error = std::format("struct '{}' has size {} when it should have {}", name, size, layout.size);
+		return 0;
 	}
+
+	size_t index = 0;
+	void* iter = nullptr;
+	while (MonoClassField* field = mono_class_get_fields(klass, &iter)) {
+		if (mono_field_get_flags(field) & MONO_FIELD_ATTR_STATIC)
+			continue;
+
+		const char* fieldName = mono_field_get_name(field);
+		if (index >= layout.fields.size() || layout.fields[index].name != fieldName) {
+			error = std::format("struct '{}' has unexpected field '{}' at index {}", name, fieldName, index);
+			return 0;
+		}
+
+		// Only plain data can be copied without marshalling
+		switch (mono_type_get_type(mono_field_get_type(field))) {
+			case MONO_TYPE_BOOLEAN:
+			case MONO_TYPE_CHAR:
+			case MONO_TYPE_I1:
+			case MONO_TYPE_U1:
+			case MONO_TYPE_I2:
+			case MONO_TYPE_U2:
+			case MONO_TYPE_I4:
+			case MONO_TYPE_U4:
+			case MONO_TYPE_I8:
+			case MONO_TYPE_U8:
+			case MONO_TYPE_R4:
+			case MONO_TYPE_R8:
+			case MONO_TYPE_I:
+			case MONO_TYPE_U:
+			case MONO_TYPE_PTR:
+			case MONO_TYPE_VALUETYPE:
+				break;
+			default:
+				error = std::format("struct '{}' field '{}' is not blittable", name, fieldName);
+				return 0;
+		}
+
+		// Offsets of value type fields include object header
+		size_t offset = mono_field_get_offset(field) - sizeof(MonoObject);
+		if (offset != layout.fields[index].offset) {
+			error = std::format("struct '{}' field '{}' has offset {} when it should have {}", name, fieldName, offset, layout.fields[index].offset);
+			return 0;
+		}
+		++index;
+	}
+
+	if (index != layout.fields.size()) {
+		error = std::format("struct '{}' has {} fields when it should have {}", name, index, layout.fields.size());
+		return 0;
+	}
+
+	_structs.emplace(klass, size);
+	return size;
+}
+
+void* CSharpLanguageModule::MonoStringToArg(MonoString* source, Arena& arena, ArgumentList& args) {
+	auto* dest = arena.Acquire<std::string>();
+	MonoStringToUTF8(source, *dest);
 	args.push_back(dest);
 	return dest;
 }
@@ -578,9 +1063,10 @@ void* CSharpLanguageModule::MonoDelegateToArg(MonoDelegate* source, const plugif
 		const void* raw = mono_lookup_internal_call_full(source->method, 0, nullptr, nullptr);
 		if (raw != nullptr) {
 			void* addr = const_cast<void*>(raw);
+			std::shared_lock lock(_functionMutex);
 			auto it = _functions.find(addr);
 			if (it != _functions.end()) {
-				return std::get<Function>(*it).GetUserData();
+				return reinterpret_cast<ImportMethod*>(std::get<Function>(*it).GetUserData())->addr;
 			} else {
 				return addr;
 			}
@@ -589,6 +1075,8 @@ void* CSharpLanguageModule::MonoDelegateToArg(MonoDelegate* source, const plugif
 
 	uint32_t ref = mono_gchandle_new_weakref(reinterpret_cast<MonoObject*>(source), 0);
 
+	std::scoped_lock<CountedMutex> lock(_delegateMutex);
+
 	auto it = _cachedDelegates.find(ref);
 	if (it != _cachedDelegates.end()) {
 		return std::get<void*>(*it);
@@ -611,6 +1099,137 @@ void* CSharpLanguageModule::MonoDelegateToArg(MonoDelegate* source, const plugif
 	return methodAddr;
 }
 
+const MarshalPlan& CSharpLanguageModule::GetMarshalPlan(const Method& method) {
+	{
+		std::shared_lock lock(_planMutex);
+		auto it = _plans.find(&method);
+		if (it != _plans.end())
+			return *std::get<std::unique_ptr<MarshalPlan>>(*it);
+	}
+
+	std::unique_lock lock(_planMutex);
+	auto& plan = _plans[&method];
+	if (!plan) {
+		plan = std::make_unique<MarshalPlan>(MarshalPlan::Build(method));
+		BindConverters(*plan, method);
+	}
+	return *plan;
+}
+
+std::optional<asmjit::TypeId> CSharpLanguageModule::GetManagedTypeId(const Property& property) {
+	if (property.ref) {
+		// Delegates by reference are passed as objects by SetParams, not as cells
+		if (property.type == ValueType::Function)
+			return std::nullopt;
+		return asmjit::TypeId::kUIntPtr;
+	}
+
+	switch (property.type) {
+		case ValueType::Void:
+			return asmjit::TypeId::kVoid;
+		case ValueType::Bool:
+		case ValueType::UInt8:
+			return asmjit::TypeId::kUInt8;
+		case ValueType::Int8:
+			return asmjit::TypeId::kInt8;
+		case ValueType::Char8:
+		case ValueType::Char16:
+		case ValueType::UInt16:
+			return asmjit::TypeId::kUInt16;
+		case ValueType::Int16:
+			return asmjit::TypeId::kInt16;
+		case ValueType::Int32:
+			return asmjit::TypeId::kInt32;
+		case ValueType::UInt32:
+			return asmjit::TypeId::kUInt32;
+		case ValueType::Int64:
+			return asmjit::TypeId::kInt64;
+		case ValueType::UInt64:
+			return asmjit::TypeId::kUInt64;
+		case ValueType::Float:
+			return asmjit::TypeId::kFloat32;
+		case ValueType::Double:
+			return asmjit::TypeId::kFloat64;
+		case ValueType::Pointer:
+		case ValueType::Function:
+			return asmjit::TypeId::kUIntPtr;
+		default:
+			if (property.type >= ValueType::FirstObject && property.type <= ValueType::LastObject)
+				return asmjit::TypeId::kUIntPtr;
+			// Structs by value have platform specific conventions in the thunk, leave them to runtime invoke
+			return std::nullopt;
+	}
+}
+
+bool CSharpLanguageModule::CreateManagedThunk(CallThunk& thunk, MonoMethod* monoMethod, bool instance, const Method& method) {
+	auto retTypeId = GetManagedTypeId(method.retType);
+	if (!retTypeId)
+		return false;
+
+	std::vector<asmjit::TypeId> argTypeIds;
+	argTypeIds.reserve(method.paramTypes.size() + 2);
+	if (instance)
+		argTypeIds.push_back(asmjit::TypeId::kUIntPtr);
+	for (const auto& param : method.paramTypes) {
+		auto typeId = GetManagedTypeId(param);
+		if (!typeId)
+			return false;
+		argTypeIds.push_back(*typeId);
+	}
+	argTypeIds.push_back(asmjit::TypeId::kUIntPtr); // MonoException**
+
+	void* addr = mono_method_get_unmanaged_thunk(monoMethod);
+	if (!addr)
+		return false;
+
+	return thunk.GetJitFunc(argTypeIds, *retTypeId, addr) != nullptr;
+}
+
+MonoObject* CSharpLanguageModule::CallManagedThunk(CallThunk::ThunkFunc func, MonoObject* instance, const MarshalPlan& plan, const ArgumentList& args, NativeSlot& result) {
+	// Unmanaged thunk takes values instead of pointers to them: [this], params..., MonoException**
+	InlineVector<NativeSlot, 16> slots;
+	slots.reserve(plan.params.size() + 2);
+	if (instance)
+		slots.push_back(reinterpret_cast<uintptr_t>(instance));
+	for (const auto& op : plan.params) {
+		NativeSlot slot{};
+		if (op.size)
+			std::memcpy(&slot, args[op.index], op.size);
+		else
+			StoreSlot(slot, args[op.index]);
+		slots.push_back(slot);
+	}
+
+	MonoObject* exception = nullptr;
+	slots.push_back(reinterpret_cast<uintptr_t>(&exception));
+
+	func(slots.data(), &result);
+	return exception;
+}
+
+const DelegateInvoker& CSharpLanguageModule::GetDelegateInvoker(MonoObject* delegate, const Method& method) {
+	std::pair<MonoClass*, const Method*> key{ mono_object_get_class(delegate), &method };
+
+	{
+		std::shared_lock lock(_invokerMutex);
+		auto it = _delegateInvokers.find(key);
+		if (it != _delegateInvokers.end())
+			return *std::get<std::unique_ptr<DelegateInvoker>>(*it);
+	}
+
+	std::unique_lock lock(_invokerMutex);
+	auto& invoker = _delegateInvokers[key];
+	if (!invoker) {
+		invoker = std::make_unique<DelegateInvoker>(CallThunk(_rt), &GetMarshalPlan(method));
+		// Unsupported signatures keep empty thunk and go through runtime delegate invoke
+		MonoMethod* invoke = mono_get_delegate_invoke(std::get<MonoClass*>(key));
+		if (!invoke || !CreateManagedThunk(invoker->thunk, invoke, true, method)) {
+			_provider->Log(std::format(LOG_PREFIX "Delegate '{}' will be called through runtime invoke: {}", method.funcName, invoker->thunk.GetError()), Severity::Verbose);
+		}
+	}
+	return *invoker;
+}
+
 void CSharpLanguageModule::CleanupDelegateCache() {
 	for (auto it = _cachedDelegates.begin(); it != _cachedDelegates.end();) {
 		if (mono_gchandle_get_target(it->first) == nullptr) {
@@ -621,222 +1240,308 @@ void CSharpLanguageModule::CleanupDelegateCache() {
 	}
 }
 
-// Call from C# to C++
-void CSharpLanguageModule::ExternalCall(const Method* method, void* addr, const Parameters* p, uint8_t count, const ReturnValue* ret) {
-	// TODO: Does mutex here good choose ?
-	std::scoped_lock<std::mutex> lock(g_monolm._mutex);
-	ArgumentList args;
+template<typename T, typename N>
+void CSharpLanguageModule::ValueToSlot(const Property&, const Parameters* p, uint8_t i, NativeSlot& slot, Arena&, ArgumentList&) {
+	StoreSlot(slot, static_cast<N>(p->GetArgument<T>(i)));
+}
 
-	DCCallVM* vm = g_monolm._callVirtMachine.get();
-	dcReset(vm);
+template<bool Ref>
+void CSharpLanguageModule::DelegateToSlot(const Property& param, const Parameters* p, uint8_t i, NativeSlot& slot, Arena&, ArgumentList&) {
+	if constexpr (Ref)
+		StoreSlot(slot, g_monolm.MonoDelegateToArg(*p->GetArgument<MonoDelegate**>(i), *param.prototype));
+	else
+		StoreSlot(slot, g_monolm.MonoDelegateToArg(p->GetArgument<MonoDelegate*>(i), *param.prototype));
+}
 
-	bool hasRet = true;
-	bool hasRefs = false;
+template<bool Ref>
+void CSharpLanguageModule::StringToSlot(const Property&, const Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args) {
+	if constexpr (Ref)
+		StoreSlot(slot, MonoStringToArg(*p->GetArgument<MonoString**>(i), arena, args));
+	else
+		StoreSlot(slot, MonoStringToArg(p->GetArgument<MonoString*>(i), arena, args));
+}
 
-	DCaggr* ag = nullptr;
+template<typename T, bool Ref>
+void CSharpLanguageModule::ArrayToSlot(const Property&, const Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args) {
+	if constexpr (Ref)
+		StoreSlot(slot, MonoArrayToArg<T>(*p->GetArgument<MonoArray**>(i), arena, args));
+	else
+		StoreSlot(slot, MonoArrayToArg<T>(p->GetArgument<MonoArray*>(i), arena, args));
+}
 
-	// Store parameters
+template<size_t Size>
+void CSharpLanguageModule::ViewToSlot(const Property&, const Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args) {
+	StoreSlot(slot, MonoArrayToView(p->GetArgument<MonoArray*>(i), Size, arena, args));
+}
 
-	switch (method->retType.type) {
+template<typename N, typename T>
+void CSharpLanguageModule::ReturnValueSlot(const ImportMethod&, const ReturnValue* ret, const NativeSlot& result, const ArgumentList&) {
+	ret->SetReturnPtr(static_cast<T>(LoadSlot<N>(result)));
+}
+
+void CSharpLanguageModule::ReturnDelegate(const ImportMethod& import, const ReturnValue* ret, const NativeSlot& result, const ArgumentList&) {
+	ret->SetReturnPtr(g_monolm.CreateDelegate(LoadSlot<void*>(result), *import.method->retType.prototype));
+}
+
+void CSharpLanguageModule::ReturnString(const ImportMethod&, const ReturnValue* ret, const NativeSlot&, const ArgumentList& args) {
+	ret->SetReturnPtr(g_monolm.CreateString(*reinterpret_cast<std::string*>(args[0])));
+}
+
+template<typename T>
+void CSharpLanguageModule::ReturnArray(const ImportMethod& import, const ReturnValue* ret, const NativeSlot&, const ArgumentList& args) {
+	ret->SetReturnPtr(g_monolm.CreateArrayT<T>(*reinterpret_cast<std::vector<T>*>(args[0]), import.plan->retClass));
+}
+
+void CSharpLanguageModule::ReturnStringArray(const ImportMethod&, const ReturnValue* ret, const NativeSlot&, const ArgumentList& args) {
+	ret->SetReturnPtr(g_monolm.CreateStringArray(*reinterpret_cast<std::vector<std::string>*>(args[0])));
+}
+
+// Array stays native and is copied out by managed side in chunks
+void CSharpLanguageModule::ReturnStream(const ImportMethod& import, const ReturnValue* ret, const NativeSlot&, const ArgumentList& args) {
+	ret->SetReturnPtr(g_monolm.CreateArrayStream(import.method->retType.type, args[0], import.plan->retClass));
+}
+
+// Packed buffer is unpacked into jagged array the extern is declared with
+void CSharpLanguageModule::ReturnJagged(const ImportMethod& import, const ReturnValue* ret, const NativeSlot&, const ArgumentList& args) {
+	ret->SetReturnPtr(JaggedArray::Unpack(*reinterpret_cast<std::vector<uint8_t>*>(args[0]), import.jaggedRow));
+}
+
+// Resolves every conversion of ExternalCall once, so the call itself does not switch on value types
+void CSharpLanguageModule::BindConverters(ImportMethod& import) {
+	const Method& method = *import.method;
+
+	switch (method.retType.type) {
+		case ValueType::Void:
+			break;
+		case ValueType::Bool:
+			import.storeReturn = &ReturnValueSlot<bool>;
+			break;
+		case ValueType::Char8:
+			import.storeReturn = &ReturnValueSlot<char, char16_t>;
+			break;
+		case ValueType::Char16:
+			import.storeReturn = &ReturnValueSlot<char16_t>;
+			break;
+		case ValueType::Int8:
+			import.storeReturn = &ReturnValueSlot<int8_t>;
+			break;
+		case ValueType::Int16:
+			import.storeReturn = &ReturnValueSlot<int16_t>;
+			break;
+		case ValueType::Int32:
+			import.storeReturn = &ReturnValueSlot<int32_t>;
+			break;
+		case ValueType::Int64:
+			import.storeReturn = &ReturnValueSlot<int64_t>;
+			break;
+		case ValueType::UInt8:
+			import.storeReturn = &ReturnValueSlot<uint8_t>;
+			break;
+		case ValueType::UInt16:
+			import.storeReturn = &ReturnValueSlot<uint16_t>;
+			break;
+		case ValueType::UInt32:
+			import.storeReturn = &ReturnValueSlot<uint32_t>;
+			break;
+		case ValueType::UInt64:
+			import.storeReturn = &ReturnValueSlot<uint64_t>;
+			break;
+		case ValueType::Pointer:
+			import.storeReturn = &ReturnValueSlot<void*>;
+			break;
+		case ValueType::Float:
+			import.storeReturn = &ReturnValueSlot<float>;
+			break;
+		case ValueType::Double:
+			import.storeReturn = &ReturnValueSlot<double>;
+			break;
+		// Aggregates are stored by dyncall
+		case ValueType::Vector2:
+		case ValueType::Vector3:
+		case ValueType::Vector4:
+		case ValueType::Matrix4x4:
+			break;
+		// MonoDelegate*
+		case ValueType::Function:
+			import.storeReturn = &ReturnDelegate;
+			break;
 		// MonoString*
 		case ValueType::String:
-			dcArgPointer(vm, AllocateMemory<std::string>(args));
+			import.allocateReturn = &AllocateMemory<std::string>;
+			import.storeReturn = &ReturnString;
 			break;
 		// MonoArray*
 		case ValueType::ArrayBool:
-			dcArgPointer(vm, AllocateMemory<std::vector<bool>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<bool>>;
+			import.storeReturn = &ReturnArray<bool>;
 			break;
 		case ValueType::ArrayChar8:
-			dcArgPointer(vm, AllocateMemory<std::vector<char>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<char>>;
+			import.storeReturn = &ReturnArray<char>;
 			break;
 		case ValueType::ArrayChar16:
-			dcArgPointer(vm, AllocateMemory<std::vector<char16_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<char16_t>>;
+			import.storeReturn = &ReturnArray<char16_t>;
 			break;
 		case ValueType::ArrayInt8:
-			dcArgPointer(vm, AllocateMemory<std::vector<int8_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<int8_t>>;
+			import.storeReturn = &ReturnArray<int8_t>;
 			break;
 		case ValueType::ArrayInt16:
-			dcArgPointer(vm, AllocateMemory<std::vector<int16_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<int16_t>>;
+			import.storeReturn = &ReturnArray<int16_t>;
 			break;
 		case ValueType::ArrayInt32:
-			dcArgPointer(vm, AllocateMemory<std::vector<int32_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<int32_t>>;
+			import.storeReturn = &ReturnArray<int32_t>;
 			break;
 		case ValueType::ArrayInt64:
-			dcArgPointer(vm, AllocateMemory<std::vector<int64_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<int64_t>>;
+			import.storeReturn = &ReturnArray<int64_t>;
 			break;
 		case ValueType::ArrayUInt8:
-			dcArgPointer(vm, AllocateMemory<std::vector<uint8_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<uint8_t>>;
+			import.storeReturn = &ReturnArray<uint8_t>;
 			break;
 		case ValueType::ArrayUInt16:
-			dcArgPointer(vm, AllocateMemory<std::vector<uint16_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<uint16_t>>;
+			import.storeReturn = &ReturnArray<uint16_t>;
 			break;
 		case ValueType::ArrayUInt32:
-			dcArgPointer(vm, AllocateMemory<std::vector<uint32_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<uint32_t>>;
+			import.storeReturn = &ReturnArray<uint32_t>;
 			break;
 		case ValueType::ArrayUInt64:
-			dcArgPointer(vm, AllocateMemory<std::vector<uint64_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<uint64_t>>;
+			import.storeReturn = &ReturnArray<uint64_t>;
 			break;
 		case ValueType::ArrayPointer:
-			dcArgPointer(vm, AllocateMemory<std::vector<uintptr_t>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<uintptr_t>>;
+			import.storeReturn = &ReturnArray<uintptr_t>;
 			break;
 		case ValueType::ArrayFloat:
-			dcArgPointer(vm, AllocateMemory<std::vector<float>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<float>>;
+			import.storeReturn = &ReturnArray<float>;
 			break;
 		case ValueType::ArrayDouble:
-			dcArgPointer(vm, AllocateMemory<std::vector<double>>(args));
+			import.allocateReturn = &AllocateMemory<std::vector<double>>;
+			import.storeReturn = &ReturnArray<double>;
 			break;
 		case ValueType::ArrayString:
-			dcArgPointer(vm, AllocateMemory<std::vector<std::string>>(args));
-			break;
-		case ValueType::Vector2:
-			ag = dcNewAggr(2, sizeof(Vector2));
-			for (int i = 0; i < 2; ++i)
-				dcAggrField(ag, DC_SIGCHAR_FLOAT, static_cast<int>(sizeof(float) * i), 1);
-			dcCloseAggr(ag);
-			dcBeginCallAggr(vm, ag);
-			hasRet = false;
-			break;
-		case ValueType::Vector3:
-			ag = dcNewAggr(3, sizeof(Vector3));
-			for (int i = 0; i < 3; ++i)
-				dcAggrField(ag, DC_SIGCHAR_FLOAT, static_cast<int>(sizeof(float) * i), 1);
-			dcCloseAggr(ag);
-			dcBeginCallAggr(vm, ag);
-			hasRet = false;
-			break;
-		case ValueType::Vector4:
-			ag = dcNewAggr(4, sizeof(Vector4));
-			for (int i = 0; i < 4; ++i)
-				dcAggrField(ag, DC_SIGCHAR_FLOAT, static_cast<int>(sizeof(float) * i), 1);
-			dcCloseAggr(ag);
-			dcBeginCallAggr(vm, ag);
-			hasRet = false;
-			break;
-		case ValueType::Matrix4x4:
-			ag = dcNewAggr(16, sizeof(Matrix4x4));
-			for (int i = 0; i < 16; ++i)
-				dcAggrField(ag, DC_SIGCHAR_FLOAT, static_cast<int>(sizeof(float) * i), 1);
-			dcCloseAggr(ag);
-			dcBeginCallAggr(vm, ag);
-			hasRet = false;
+			import.allocateReturn = &AllocateMemory<std::vector<std::string>>;
+			import.storeReturn = &ReturnStringArray;
 			break;
 		default:
-			// Should not require storage
-			hasRet = false;
+			std::puts("Unsupported types!\n");
+			std::terminate();
 			break;
 	}
 
-	for (uint8_t i = 0; i < count; ++i) {
-		const auto& param = method->paramTypes[i];
+	if (import.stream)
+		import.storeReturn = &ReturnStream;
+	else if (import.jaggedRow)
+		import.storeReturn = &ReturnJagged;
+
+	import.converters.clear();
+	import.converters.reserve(method.paramTypes.size());
+
+	for (size_t i = 0; i < method.paramTypes.size(); ++i) {
+		const auto& param = method.paramTypes[i];
+		ArgConverter converter = nullptr;
 		if (param.ref) {
 			switch (param.type) {
 				case ValueType::Bool:
-					dcArgPointer(vm, p->GetArgument<bool*>(i));
-					break;
 				case ValueType::Char8:
-					dcArgPointer(vm, p->GetArgument<char*>(i));
-					break;
 				case ValueType::Char16:
-					dcArgPointer(vm, p->GetArgument<char16_t*>(i));
-					break;
 				case ValueType::Int8:
-					dcArgPointer(vm, p->GetArgument<int8_t*>(i));
-					break;
 				case ValueType::Int16:
-					dcArgPointer(vm, p->GetArgument<int16_t*>(i));
-					break;
 				case ValueType::Int32:
-					dcArgPointer(vm, p->GetArgument<int32_t*>(i));
-					break;
 				case ValueType::Int64:
-					dcArgPointer(vm, p->GetArgument<int64_t*>(i));
-					break;
 				case ValueType::UInt8:
-					dcArgPointer(vm, p->GetArgument<uint8_t*>(i));
-					break;
 				case ValueType::UInt16:
-					dcArgPointer(vm, p->GetArgument<uint16_t*>(i));
-					break;
 				case ValueType::UInt32:
-					dcArgPointer(vm, p->GetArgument<uint32_t*>(i));
-					break;
 				case ValueType::UInt64:
-					dcArgPointer(vm, p->GetArgument<uint64_t*>(i));
-					break;
 				case ValueType::Pointer:
-					dcArgPointer(vm, p->GetArgument<void*>(i));
-					break;
 				case ValueType::Float:
-					dcArgPointer(vm, p->GetArgument<float*>(i));
-					break;
 				case ValueType::Double:
-					dcArgPointer(vm, p->GetArgument<double*>(i));
-					break;
 				case ValueType::Vector2:
-					dcArgPointer(vm, p->GetArgument<Vector2*>(i));
-					break;
 				case ValueType::Vector3:
-					dcArgPointer(vm, p->GetArgument<Vector3*>(i));
-					break;
 				case ValueType::Vector4:
-					dcArgPointer(vm, p->GetArgument<Vector4*>(i));
-					break;
 				case ValueType::Matrix4x4:
-					dcArgPointer(vm, p->GetArgument<Matrix4x4*>(i));
+					converter = &ValueToSlot<void*>;
 					break;
 				// MonoDelegate*
 				case ValueType::Function:
-					dcArgPointer(vm, g_monolm.MonoDelegateToArg(*p->GetArgument<MonoDelegate**>(i), *param.prototype));
+					converter = &DelegateToSlot<true>;
 					break;
 				// MonoString*
 				case ValueType::String:
-					dcArgPointer(vm, MonoStringToArg(*p->GetArgument<MonoString**>(i), args));
+					converter = &StringToSlot<true>;
 					break;
 				// MonoArray*
 				case ValueType::ArrayBool:
-					dcArgPointer(vm, MonoArrayToArg<bool>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<bool, true>;
 					break;
 				case ValueType::ArrayChar8:
-					dcArgPointer(vm, MonoArrayToArg<char>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<char, true>;
 					break;
 				case ValueType::ArrayChar16:
-					dcArgPointer(vm, MonoArrayToArg<char16_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<char16_t, true>;
 					break;
 				case ValueType::ArrayInt8:
-					dcArgPointer(vm, MonoArrayToArg<int8_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<int8_t, true>;
 					break;
 				case ValueType::ArrayInt16:
-					dcArgPointer(vm, MonoArrayToArg<int16_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<int16_t, true>;
 					break;
 				case ValueType::ArrayInt32:
-					dcArgPointer(vm, MonoArrayToArg<int32_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<int32_t, true>;
 					break;
 				case ValueType::ArrayInt64:
-					dcArgPointer(vm, MonoArrayToArg<int64_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<int64_t, true>;
 					break;
 				case ValueType::ArrayUInt8:
-					dcArgPointer(vm, MonoArrayToArg<uint8_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<uint8_t, true>;
 					break;
 				case ValueType::ArrayUInt16:
-					dcArgPointer(vm, MonoArrayToArg<uint16_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<uint16_t, true>;
 					break;
 				case ValueType::ArrayUInt32:
-					dcArgPointer(vm, MonoArrayToArg<uint32_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<uint32_t, true>;
 					break;
 				case ValueType::ArrayUInt64:
-					dcArgPointer(vm, MonoArrayToArg<uint64_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<uint64_t, true>;
 					break;
 				case ValueType::ArrayPointer:
-					dcArgPointer(vm, MonoArrayToArg<uintptr_t>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<uintptr_t, true>;
 					break;
 				case ValueType::ArrayFloat:
-					dcArgPointer(vm, MonoArrayToArg<float>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<float, true>;
 					break;
 				case ValueType::ArrayDouble:
-					dcArgPointer(vm, MonoArrayToArg<double>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<double, true>;
 					break;
 				case ValueType::ArrayString:
-					dcArgPointer(vm, MonoArrayToArg<std::string>(*p->GetArgument<MonoArray**>(i), args));
+					converter = &ArrayToSlot<std::string, true>;
+					break;
+				default:
+					std::puts("Unsupported types!\n");
+					std::terminate();
+					break;
+			}
+		} else if (import.views.test(i)) {
+			switch (GetArrayViewElementSize(param.type)) {
+				case 1:
+					converter = &ViewToSlot<1>;
+					break;
+				case 2:
+					converter = &ViewToSlot<2>;
+					break;
+				case 4:
+					converter = &ViewToSlot<4>;
+					break;
+				case 8:
+					converter = &ViewToSlot<8>;
 					break;
 				default:
 					std::puts("Unsupported types!\n");
@@ -846,104 +1551,96 @@ void CSharpLanguageModule::ExternalCall(const Method* method, void* addr, const
 		} else {
 			switch (param.type) {
 				case ValueType::Bool:
-					dcArgBool(vm, p->GetArgument<bool>(i));
+					converter = &ValueToSlot<bool>;
 					break;
 				case ValueType::Char8:
-					dcArgChar(vm, static_cast<char>(p->GetArgument<char16_t>(i)));
+					converter = &ValueToSlot<char16_t, char>;
 					break;
 				case ValueType::Char16:
-					dcArgShort(vm, static_cast<short>(p->GetArgument<char16_t>(i)));
+					converter = &ValueToSlot<char16_t>;
 					break;
 				case ValueType::Int8:
 				case ValueType::UInt8:
-					dcArgChar(vm, p->GetArgument<int8_t>(i));
+					converter = &ValueToSlot<int8_t>;
 					break;
 				case ValueType::Int16:
 				case ValueType::UInt16:
-					dcArgShort(vm, p->GetArgument<int16_t>(i));
+					converter = &ValueToSlot<int16_t>;
 					break;
 				case ValueType::Int32:
 				case ValueType::UInt32:
-					dcArgInt(vm, p->GetArgument<int32_t>(i));
+					converter = &ValueToSlot<int32_t>;
 					break;
 				case ValueType::Int64:
 				case ValueType::UInt64:
-					dcArgLongLong(vm, p->GetArgument<int64_t>(i));
-					break;
-				case ValueType::Pointer:
-					dcArgPointer(vm, p->GetArgument<void*>(i));
+					converter = &ValueToSlot<int64_t>;
 					break;
 				case ValueType::Float:
-					dcArgFloat(vm, p->GetArgument<float>(i));
+					converter = &ValueToSlot<float>;
 					break;
 				case ValueType::Double:
-					dcArgDouble(vm, p->GetArgument<double>(i));
+					converter = &ValueToSlot<double>;
 					break;
+				case ValueType::Pointer:
 				case ValueType::Vector2:
-					dcArgPointer(vm, p->GetArgument<Vector2*>(i));
-					break;
 				case ValueType::Vector3:
-					dcArgPointer(vm, p->GetArgument<Vector3*>(i));
-					break;
 				case ValueType::Vector4:
-					dcArgPointer(vm, p->GetArgument<Vector4*>(i));
-					break;
 				case ValueType::Matrix4x4:
-					dcArgPointer(vm, p->GetArgument<Matrix4x4*>(i));
+					converter = &ValueToSlot<void*>;
 					break;
 				// MonoDelegate*
 				case ValueType::Function:
-					dcArgPointer(vm, g_monolm.MonoDelegateToArg(p->GetArgument<MonoDelegate*>(i), *param.prototype));
+					converter = &DelegateToSlot<false>;
 					break;
 				// MonoString*
 				case ValueType::String:
-					dcArgPointer(vm, MonoStringToArg(p->GetArgument<MonoString*>(i), args));
+					converter = &StringToSlot<false>;
 					break;
 				// MonoArray*
 				case ValueType::ArrayBool:
-					dcArgPointer(vm, MonoArrayToArg<bool>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<bool, false>;
 					break;
 				case ValueType::ArrayChar8:
-					dcArgPointer(vm, MonoArrayToArg<char>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<char, false>;
 					break;
 				case ValueType::ArrayChar16:
-					dcArgPointer(vm, MonoArrayToArg<char16_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<char16_t, false>;
 					break;
 				case ValueType::ArrayInt8:
-					dcArgPointer(vm, MonoArrayToArg<int8_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<int8_t, false>;
 					break;
 				case ValueType::ArrayInt16:
-					dcArgPointer(vm, MonoArrayToArg<int16_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<int16_t, false>;
 					break;
 				case ValueType::ArrayInt32:
-					dcArgPointer(vm, MonoArrayToArg<int32_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<int32_t, false>;
 					break;
 				case ValueType::ArrayInt64:
-					dcArgPointer(vm, MonoArrayToArg<int64_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<int64_t, false>;
 					break;
 				case ValueType::ArrayUInt8:
-					dcArgPointer(vm, MonoArrayToArg<uint8_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<uint8_t, false>;
 					break;
 				case ValueType::ArrayUInt16:
-					dcArgPointer(vm, MonoArrayToArg<uint16_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<uint16_t, false>;
 					break;
 				case ValueType::ArrayUInt32:
-					dcArgPointer(vm, MonoArrayToArg<uint32_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<uint32_t, false>;
 					break;
 				case ValueType::ArrayUInt64:
-					dcArgPointer(vm, MonoArrayToArg<uint64_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<uint64_t, false>;
 					break;
 				case ValueType::ArrayPointer:
-					dcArgPointer(vm, MonoArrayToArg<uintptr_t>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<uintptr_t, false>;
 					break;
 				case ValueType::ArrayFloat:
-					dcArgPointer(vm, MonoArrayToArg<float>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<float, false>;
 					break;
 				case ValueType::ArrayDouble:
-					dcArgPointer(vm, MonoArrayToArg<double>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<double, false>;
 					break;
 				case ValueType::ArrayString:
-					dcArgPointer(vm, MonoArrayToArg<std::string>(p->GetArgument<MonoArray*>(i), args));
+					converter = &ArrayToSlot<std::string, false>;
 					break;
 				default:
 					std::puts("Unsupported types!\n");
@@ -951,1146 +1648,1193 @@ void CSharpLanguageModule::ExternalCall(const Method* method, void* addr, const
 					break;
 			}
 		}
-		hasRefs |= param.ref;
+		import.converters.push_back(converter);
 	}
+}
 
-	// Call function and store return
+// Call from C# to C++
+void CSharpLanguageModule::ExternalCall(const Method* method, void* data, const Parameters* p, uint8_t count, const ReturnValue* ret) {
+	const auto& import = *reinterpret_cast<ImportMethod*>(data);
 
-	switch (method->retType.type) {
-		case ValueType::Void: {
-			dcCallVoid(vm, addr);
-			break;
-		}
-		case ValueType::Bool: {
-			bool val = dcCallBool(vm, addr);
-			ret->SetReturnPtr(val);
-			break;
-		}
-		case ValueType::Char8: {
-			char16_t val = static_cast<char16_t>(dcCallChar(vm, addr));
-			ret->SetReturnPtr(val);
-			break;
-		}
-		case ValueType::Char16: {
-			char16_t val = static_cast<char16_t>(dcCallShort(vm, addr));
-			ret->SetReturnPtr(val);
-			break;
-		}
-		case ValueType::Int8: {
-			int8_t val = dcCallChar(vm, addr);
-			ret->SetReturnPtr(val);
-			break;
-		}
-		case ValueType::Int16: {
-			int16_t val = dcCallShort(vm, addr);
-			ret->SetReturnPtr(val);
-			break;
-		}
-		case ValueType::Int32: {
-			int32_t val = dcCallInt(vm, addr);
-			ret->SetReturnPtr(val);
-			break;
+	// All temporaries are released in bulk when the scope ends
+	Arena& arena = CallContext::Get().GetArena();
+	Arena::Scope scope(arena);
+
+	ArgumentList args;
+
+	std::array<NativeSlot, std::numeric_limits<uint8_t>::max() + 1> slots;
+	uint8_t n = 0;
+
+	// Store parameters, conversions were chosen by BindConverters
+
+	bool hasRet = import.allocateReturn != nullptr;
+	if (hasRet)
+		StoreSlot(slots[n++], import.allocateReturn(arena, args));
+
+	for (uint8_t i = 0; i < count; ++i) {
+		import.converters[i](method->paramTypes[i], p, i, slots[n++], arena, args);
+	}
+
+	// Call function
+
+	NativeSlot result{};
+
+	if (auto func = import.thunk.GetFunction()) {
+		func(slots.data(), &result);
+	} else if (!CallVirtMachine(method, import.addr, p, ret, slots.data(), n, hasRet, result)) {
+		// Aggregate return already stored by dyncall
+		PullReferences(*import.plan, p, args);
+		return;
+	}
+
+	// Store return
+
+	if (import.storeReturn)
+		import.storeReturn(import, ret, result, args);
+
+	// Pull back references into provided arguments
+
+	PullReferences(*import.plan, p, args);
+}
+
+// Fallback for signatures without thunk, returns false if return was already stored (aggregates)
+bool CSharpLanguageModule::CallVirtMachine(const Method* method, void* addr, const Parameters* p, const ReturnValue* ret, const NativeSlot* slots, uint8_t count, bool hasRet, NativeSlot& result) {
+	DCCallVM* vm = CallContext::Get().GetVirtMachine();
+	dcReset(vm);
+
+	const DCaggr* ag = g_monolm.GetAggregates().Get(method->retType.type);
+	if (ag) {
+		dcBeginCallAggr(vm, ag);
+	}
+
+	uint8_t j = 0;
+
+	if (hasRet) {
+		dcArgPointer(vm, LoadSlot<void*>(slots[j++]));
+	}
+
+	for (uint8_t i = 0; j < count; ++i, ++j) {
+		const auto& param = method->paramTypes[i];
+		if (param.ref) {
+			dcArgPointer(vm, LoadSlot<void*>(slots[j]));
+			continue;
 		}
-		case ValueType::Int64: {
-			int64_t val = dcCallLongLong(vm, addr);
-			ret->SetReturnPtr(val);
-			break;
+		switch (param.type) {
+			case ValueType::Bool:
+				dcArgBool(vm, LoadSlot<bool>(slots[j]));
+				break;
+			case ValueType::Char8:
+			case ValueType::Int8:
+			case ValueType::UInt8:
+				dcArgChar(vm, LoadSlot<char>(slots[j]));
+				break;
+			case ValueType::Char16:
+			case ValueType::Int16:
+			case ValueType::UInt16:
+				dcArgShort(vm, LoadSlot<short>(slots[j]));
+				break;
+			case ValueType::Int32:
+			case ValueType::UInt32:
+				dcArgInt(vm, LoadSlot<int32_t>(slots[j]));
+				break;
+			case ValueType::Int64:
+			case ValueType::UInt64:
+				dcArgLongLong(vm, LoadSlot<int64_t>(slots[j]));
+				break;
+			case ValueType::Float:
+				dcArgFloat(vm, LoadSlot<float>(slots[j]));
+				break;
+			case ValueType::Double:
+				dcArgDouble(vm, LoadSlot<double>(slots[j]));
+				break;
+			default:
+				dcArgPointer(vm, LoadSlot<void*>(slots[j]));
+				break;
 		}
-		case ValueType::UInt8: {
-			uint8_t val = static_cast<uint8_t>(dcCallChar(vm, addr));
-			ret->SetReturnPtr(val);
+	}
+
+	switch (method->retType.type) {
+		case ValueType::Bool:
+			StoreSlot(result, dcCallBool(vm, addr) != 0);
 			break;
-		}
-		case ValueType::UInt16: {
-			uint16_t val = static_cast<uint16_t>(dcCallShort(vm, addr));
-			ret->SetReturnPtr(val);
+		case ValueType::Char8:
+		case ValueType::Int8:
+		case ValueType::UInt8:
+			StoreSlot(result, dcCallChar(vm, addr));
 			break;
-		}
-		case ValueType::UInt32: {
-			uint32_t val = static_cast<uint32_t>(dcCallInt(vm, addr));
-			ret->SetReturnPtr(val);
+		case ValueType::Char16:
+		case ValueType::Int16:
+		case ValueType::UInt16:
+			StoreSlot(result, dcCallShort(vm, addr));
 			break;
-		}
-		case ValueType::UInt64: {
-			uint64_t val = static_cast<uint64_t>(dcCallLongLong(vm, addr));
-			ret->SetReturnPtr(val);
+		case ValueType::Int32:
+		case ValueType::UInt32:
+			StoreSlot(result, dcCallInt(vm, addr));
 			break;
-		}
-		case ValueType::Pointer: {
-			void* val = dcCallPointer(vm, addr);
-			ret->SetReturnPtr(val);
+		case ValueType::Int64:
+		case ValueType::UInt64:
+			StoreSlot(result, dcCallLongLong(vm, addr));
 			break;
-		}
-		case ValueType::Float: {
-			float val = dcCallFloat(vm, addr);
-			ret->SetReturnPtr(val);
+		case ValueType::Pointer:
+		case ValueType::Function:
+			StoreSlot(result, dcCallPointer(vm, addr));
 			break;
-		}
-		case ValueType::Double: {
-			double val = dcCallDouble(vm, addr);
-			ret->SetReturnPtr(val);
+		case ValueType::Float:
+			StoreSlot(result, dcCallFloat(vm, addr));
 			break;
-		}
-		case ValueType::Function: {
-			void* val = dcCallPointer(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateDelegate(val, *method->retType.prototype));
+		case ValueType::Double:
+			StoreSlot(result, dcCallDouble(vm, addr));
 			break;
-		}
 		case ValueType::Vector2: {
 			Vector2 source;
 			dcCallAggr(vm, addr, ag, &source);
 			ret->SetReturnPtr(source);
-			dcFreeAggr(ag);
-			break;
+			return false;
 		}
 #if MONOLM_PLATFORM_WINDOWS
 		case ValueType::Vector3: {
 			auto* dest = p->GetArgument<Vector3*>(0);
 			dcCallAggr(vm, addr, ag, dest);
 			ret->SetReturnPtr(dest);
-			dcFreeAggr(ag);
-			break;
+			return false;
 		}
 		case ValueType::Vector4: {
 			auto* dest = p->GetArgument<Vector4*>(0);
 			dcCallAggr(vm, addr, ag, dest);
 			ret->SetReturnPtr(dest);
-			dcFreeAggr(ag);
-			break;
+			return false;
 		}
 #else
 		case ValueType::Vector3: {
 			Vector3 source;
 			dcCallAggr(vm, addr, ag, &source);
 			ret->SetReturnPtr(source);
-			dcFreeAggr(ag);
-			break;
+			return false;
 		}
 		case ValueType::Vector4: {
 			Vector4 source;
 			dcCallAggr(vm, addr, ag, &source);
 			ret->SetReturnPtr(source);
-			dcFreeAggr(ag);
-			break;
+			return false;
 		}
 #endif
 		case ValueType::Matrix4x4: {
 			auto* dest = p->GetArgument<Matrix4x4*>(0);
 			dcCallAggr(vm, addr, ag, dest);
 			ret->SetReturnPtr(dest);
-			dcFreeAggr(ag);
-			break;
-		}
-		case ValueType::String: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateString(*reinterpret_cast<std::string*>(args[0])));
-			break;
-		}
-		case ValueType::ArrayBool: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<bool>(*reinterpret_cast<std::vector<bool>*>(args[0]), mono_get_byte_class()));
-			break;
-		}
-		case ValueType::ArrayChar8: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<char>(*reinterpret_cast<std::vector<char>*>(args[0]), mono_get_char_class()));
-			break;
-		}
-		case ValueType::ArrayChar16: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<char16_t>(*reinterpret_cast<std::vector<char16_t>*>(args[0]), mono_get_char_class()));
-			break;
-		}
-		case ValueType::ArrayInt8: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<int8_t>(*reinterpret_cast<std::vector<int8_t>*>(args[0]), mono_get_sbyte_class()));
-			break;
-		}
-		case ValueType::ArrayInt16: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<int16_t>(*reinterpret_cast<std::vector<int16_t>*>(args[0]), mono_get_int16_class()));
-			break;
-		}
-		case ValueType::ArrayInt32: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<int32_t>(*reinterpret_cast<std::vector<int32_t>*>(args[0]), mono_get_int32_class()));
-			break;
-		}
-		case ValueType::ArrayInt64: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<int64_t>(*reinterpret_cast<std::vector<int64_t>*>(args[0]), mono_get_int64_class()));
-			break;
-		}
-		case ValueType::ArrayUInt8: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<uint8_t>(*reinterpret_cast<std::vector<uint8_t>*>(args[0]), mono_get_byte_class()));
-			break;
-		}
-		case ValueType::ArrayUInt16: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<uint16_t>(*reinterpret_cast<std::vector<uint16_t>*>(args[0]), mono_get_uint16_class()));
-			break;
-		}
-		case ValueType::ArrayUInt32: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<uint32_t>(*reinterpret_cast<std::vector<uint32_t>*>(args[0]), mono_get_uint32_class()));
-			break;
-		}
-		case ValueType::ArrayUInt64: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<uint64_t>(*reinterpret_cast<std::vector<uint64_t>*>(args[0]), mono_get_uint64_class()));
-			break;
-		}
-		case ValueType::ArrayPointer: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<uintptr_t>(*reinterpret_cast<std::vector<uintptr_t>*>(args[0]), mono_get_intptr_class()));
-			break;
-		}
-		case ValueType::ArrayFloat: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<float>(*reinterpret_cast<std::vector<float>*>(args[0]), mono_get_single_class()));
-			break;
-		}
-		case ValueType::ArrayDouble: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateArrayT<double>(*reinterpret_cast<std::vector<double>*>(args[0]), mono_get_double_class()));
-			break;
-		}
-		case ValueType::ArrayString: {
-			dcCallVoid(vm, addr);
-			ret->SetReturnPtr(g_monolm.CreateStringArray(*reinterpret_cast<std::vector<std::string>*>(args[0])));
-			break;
+			return false;
 		}
 		default:
-			std::puts("Unsupported types!\n");
-			std::terminate();
+			dcCallVoid(vm, addr);
 			break;
 	}
 
-	// Pull back references into provided arguments
-
-	PullReferences(method, p, count, hasRet, hasRefs, args);
-
-	if (!args.empty()) {
-		uint8_t j = 0;
-
-		if (hasRet) {
-			DeleteReturn(args, j, method->retType.type);
-		}
+	return true;
+}
 
-		if (j < args.size()) {
-			for (uint8_t i = 0; i < count; ++i) {
-				DeleteParam(args, j, method->paramTypes[i].type);
-				if (j == args.size())
+void CSharpLanguageModule::PullReferences(const MarshalPlan& plan, const Parameters* p, const ArgumentList& args) {
+	for (const auto& op : plan.writeBack) {
+		if (op.ref) {
+			uint8_t i = op.index;
+			switch (op.type) {
+				case ValueType::String:
+					p->SetArgumentAt(i, g_monolm.UpdateString(*p->GetArgument<MonoString**>(i), *reinterpret_cast<std::string*>(args[op.slot])));
+					break;
+				case ValueType::ArrayBool:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<bool>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<bool>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayChar8:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<char>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<char>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayChar16:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<char16_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<char16_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayInt8:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<int8_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<int8_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayInt16:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<int16_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<int16_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayInt32:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<int32_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<int32_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayInt64:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<int64_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<int64_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayUInt8:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<uint8_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<uint8_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayUInt16:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<uint16_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<uint16_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayUInt32:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<uint32_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<uint32_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayUInt64:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<uint64_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<uint64_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayPointer:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<uintptr_t>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<uintptr_t>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayFloat:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<float>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<float>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayDouble:
+					p->SetArgumentAt(i, g_monolm.UpdateArrayT<double>(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<double>*>(args[op.slot]), op.klass));
+					break;
+				case ValueType::ArrayString:
+					p->SetArgumentAt(i, g_monolm.UpdateStringArray(*p->GetArgument<MonoArray**>(i), *reinterpret_cast<std::vector<std::string>*>(args[op.slot])));
+					break;
+				default:
 					break;
 			}
 		}
 	}
 }
 
-void CSharpLanguageModule::PullReferences(const Method* method, const Parameters* p, uint8_t count, bool hasRet, bool hasRefs, const ArgumentList& args) {
-	if (hasRefs) {
-		uint8_t j = hasRet; // skip first param if has return
-
-		if (j < args.size()) {
-			for (uint8_t i = 0; i < count; ++i) {
-				const auto& param = method->paramTypes[i];
-				if (param.ref) {
-					switch (param.type) {
-						case ValueType::String:
-							p->SetArgumentAt(i, g_monolm.CreateString(*reinterpret_cast<std::string*>(args[j++])));
-							break;
-						case ValueType::ArrayBool:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<bool>(*reinterpret_cast<std::vector<bool>*>(args[j++]), mono_get_byte_class()));
-							break;
-						case ValueType::ArrayChar8:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<char>(*reinterpret_cast<std::vector<char>*>(args[j++]), mono_get_char_class()));
-							break;
-						case ValueType::ArrayChar16:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<char16_t>(*reinterpret_cast<std::vector<char16_t>*>(args[j++]), mono_get_char_class()));
-							break;
-						case ValueType::ArrayInt8:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<int8_t>(*reinterpret_cast<std::vector<int8_t>*>(args[j++]), mono_get_sbyte_class()));
-							break;
-						case ValueType::ArrayInt16:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<int16_t>(*reinterpret_cast<std::vector<int16_t>*>(args[j++]), mono_get_int16_class()));
-							break;
-						case ValueType::ArrayInt32:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<int32_t>(*reinterpret_cast<std::vector<int32_t>*>(args[j++]), mono_get_int32_class()));
-							break;
-						case ValueType::ArrayInt64:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<int64_t>(*reinterpret_cast<std::vector<int64_t>*>(args[j++]), mono_get_int64_class()));
-							break;
-						case ValueType::ArrayUInt8:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<uint8_t>(*reinterpret_cast<std::vector<uint8_t>*>(args[j++]), mono_get_byte_class()));
-							break;
-						case ValueType::ArrayUInt16:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<uint16_t>(*reinterpret_cast<std::vector<uint16_t>*>(args[j++]), mono_get_uint16_class()));
-							break;
-						case ValueType::ArrayUInt32:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<uint32_t>(*reinterpret_cast<std::vector<uint32_t>*>(args[j++]), mono_get_uint32_class()));
-							break;
-						case ValueType::ArrayUInt64:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<uint64_t>(*reinterpret_cast<std::vector<uint64_t>*>(args[j++]), mono_get_uint64_class()));
-							break;
-						case ValueType::ArrayPointer:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<uintptr_t>(*reinterpret_cast<std::vector<uintptr_t>*>(args[j++]), mono_get_intptr_class()));
-							break;
-						case ValueType::ArrayFloat:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<float>(*reinterpret_cast<std::vector<float>*>(args[j++]), mono_get_single_class()));
-							break;
-						case ValueType::ArrayDouble:
-							p->SetArgumentAt(i, g_monolm.CreateArrayT<double>(*reinterpret_cast<std::vector<double>*>(args[j++]), mono_get_double_class()));
-							break;
-						case ValueType::ArrayString:
-							p->SetArgumentAt(i, g_monolm.CreateStringArray(*reinterpret_cast<std::vector<std::string>*>(args[j++])));
-							break;
-						default:
-							break;
-					}
-				}
-				if (j == args.size())
-					break;
-			}
+// Call from C++ to C#
+void CSharpLanguageModule::InternalCall(const Method* method, void* data, const Parameters* p, uint8_t /* count */, const ReturnValue* ret) {
+	ThreadAttachment::Ensure();
+
+	const auto& [monoMethod, monoObject, plan, thunk] = *reinterpret_cast<ExportMethod*>(data);
+
+	// Ref cells and widened chars live in the per-thread arena until the end of the call
+	Arena& arena = CallContext::Get().GetArena();
+	Arena::Scope scope(arena);
+
+	ArgumentList args;
+	args.reserve(plan->params.size());
+
+	SetParams(*plan, p, arena, args);
+
+	if (auto func = thunk.GetFunction()) {
+		NativeSlot result{};
+		MonoObject* exception = CallManagedThunk(func, monoObject, *plan, args, result);
+		if (exception) {
+			HandleException(exception, nullptr);
+			ret->SetReturnPtr(uintptr_t{});
+			return;
 		}
+
+		SetReferences(*plan, p, args);
+
+		SetReturnSlot(*plan, method, p, ret, result);
+		return;
 	}
-}
 
-void CSharpLanguageModule::DeleteParam(const ArgumentList& args, uint8_t& i, ValueType type) {
-	switch (type) {
-		case ValueType::String:
-			delete reinterpret_cast<std::string*>(args[i++]);
-			break;
-		case ValueType::ArrayBool:
-			delete reinterpret_cast<std::vector<bool>*>(args[i++]);
-			break;
-		case ValueType::ArrayChar8:
-			delete reinterpret_cast<std::vector<char>*>(args[i++]);
-			break;
-		case ValueType::ArrayChar16:
-			delete reinterpret_cast<std::vector<char16_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayInt8:
-			delete reinterpret_cast<std::vector<int16_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayInt16:
-			delete reinterpret_cast<std::vector<int16_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayInt32:
-			delete reinterpret_cast<std::vector<int32_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayInt64:
-			delete reinterpret_cast<std::vector<int64_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayUInt8:
-			delete reinterpret_cast<std::vector<uint8_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayUInt16:
-			delete reinterpret_cast<std::vector<uint16_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayUInt32:
-			delete reinterpret_cast<std::vector<uint32_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayUInt64:
-			delete reinterpret_cast<std::vector<uint64_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayPointer:
-			delete reinterpret_cast<std::vector<uintptr_t>*>(args[i++]);
-			break;
-		case ValueType::ArrayFloat:
-			delete reinterpret_cast<std::vector<float>*>(args[i++]);
-			break;
-		case ValueType::ArrayDouble:
-			delete reinterpret_cast<std::vector<double>*>(args[i++]);
-			break;
-		case ValueType::ArrayString:
-			delete reinterpret_cast<std::vector<std::string>*>(args[i++]);
-			break;
-		default:
-			break;
+	MonoObject* exception = nullptr;
+	MonoObject* result = mono_runtime_invoke(monoMethod, monoObject, args.data(), &exception);
+	if (exception) {
+		HandleException(exception, nullptr);
+		ret->SetReturnPtr(uintptr_t{});
+		return;
 	}
+
+	SetReferences(*plan, p, args);
+
+	SetReturn(*plan, method, p, ret, result);
 }
 
-void CSharpLanguageModule::DeleteReturn(const ArgumentList& args, uint8_t& i, ValueType type) {
-	switch (type) {
-		/*case ValueType::Vector2:
-			FreeMemory<plugify::Vector2>(args[i++]);
-			break;
-		case ValueType::Vector3:
-			FreeMemory<plugify::Vector3>(args[i++]);
-			break;
-		case ValueType::Vector4:
-			FreeMemory<plugify::Vector4>(args[i++]);
-			break;
-		case ValueType::Matrix4x4:
-			FreeMemory<plugify::Matrix4x4>(args[i++]);
-			break;*/
-		case ValueType::String:
-			FreeMemory<std::string>(args[i++]);
-			break;
+// Call from C++ to C#
+void CSharpLanguageModule::DelegateCall(const Method* method, void* data, const Parameters* p, uint8_t /* count */, const ReturnValue* ret) {
+	ThreadAttachment::Ensure();
+
+	auto* monoDelegate = reinterpret_cast<MonoObject*>(data);
+	const auto& [thunk, plan] = g_monolm.GetDelegateInvoker(monoDelegate, *method);
+
+	// Ref cells and widened chars live in the per-thread arena until the end of the call
+	Arena& arena = CallContext::Get().GetArena();
+	Arena::Scope scope(arena);
+
+	ArgumentList args;
+	args.reserve(plan->params.size());
+
+	SetParams(*plan, p, arena, args);
+
+	if (auto func = thunk.GetFunction()) {
+		NativeSlot result{};
+		MonoObject* exception = CallManagedThunk(func, monoDelegate, *plan, args, result);
+		if (exception) {
+			HandleException(exception, nullptr);
+			ret->SetReturnPtr(uintptr_t{});
+			return;
+		}
+
+		SetReferences(*plan, p, args);
+
+		SetReturnSlot(*plan, method, p, ret, result);
+		return;
+	}
+
+	MonoObject* exception = nullptr;
+	MonoObject* result = mono_runtime_delegate_invoke(monoDelegate, args.data(), &exception);
+	if (exception) {
+		HandleException(exception, nullptr);
+		ret->SetReturnPtr(uintptr_t{});
+		return;
+	}
+
+	SetReferences(*plan, p, args);
+
+	SetReturn(*plan, method, p, ret, result);
+}
+
+// Call from C++ to C# for every element of argument columns
+void CSharpLanguageModule::BatchCall(const Method* /* method */, void* data, const Parameters* p, uint8_t /* count */, const ReturnValue* /* ret */) {
+	ThreadAttachment::Ensure();
+
+	const auto& batch = *reinterpret_cast<const BatchMethod*>(data);
+
+	auto* columns = p->GetArgument<const void* const*>(0);
+	auto* results = p->GetArgument<void*>(1);
+	auto count = p->GetArgument<int32_t>(2);
+	if (count <= 0)
+		return;
+
+	// Single transition for whole batch, loop itself is compiled on managed side
+	MonoException* exception = nullptr;
+	g_monolm._invokeBatch(batch.id, batch.target->instance, columns, results, count, &exception);
+	if (exception) {
+		HandleException(reinterpret_cast<MonoObject*>(exception), nullptr);
+	}
+}
+
+bool CSharpLanguageModule::CallInto(const IntoMethod& into, const Parameters* p, MonoObject*& result) {
+	const auto& [monoMethod, monoObject, plan, thunk] = *into.target;
+
+	// Ref cells and widened chars live in the per-thread arena until the end of the call
+	Arena& arena = CallContext::Get().GetArena();
+	Arena::Scope scope(arena);
+
+	ArgumentList args;
+	args.reserve(plan->params.size());
+
+	SetParams(*plan, p, arena, args);
+
+	MonoObject* exception = nullptr;
+	if (auto func = thunk.GetFunction()) {
+		NativeSlot slot{};
+		exception = CallManagedThunk(func, monoObject, *plan, args, slot);
+		result = LoadSlot<MonoObject*>(slot);
+	} else {
+		result = mono_runtime_invoke(monoMethod, monoObject, args.data(), &exception);
+	}
+	if (exception) {
+		HandleException(exception, nullptr);
+		return false;
+	}
+
+	SetReferences(*plan, p, args);
+	return true;
+}
+
+// Call from C++ to C#, return is assigned into container which caller keeps between calls
+void CSharpLanguageModule::InternalCallInto(const Method* /* method */, void* data, const Parameters* p, uint8_t /* count */, const ReturnValue* ret) {
+	ThreadAttachment::Ensure();
+
+	const auto& into = *reinterpret_cast<const IntoMethod*>(data);
+
+	// On exception container is left as it was, null result clears it
+	MonoObject* result = nullptr;
+	if (CallInto(into, p, result))
+		AssignReturn(*into.method, p, result);
+
+	ret->SetReturnPtr(p->GetArgument<void*>(0));
+}
+
+// Call from C++ to C#, return is copied into capacity bounded buffer
+void CSharpLanguageModule::InternalCallIntoBuffer(const Method* /* method */, void* data, const Parameters* p, uint8_t /* count */, const ReturnValue* ret) {
+	ThreadAttachment::Ensure();
+
+	const auto& into = *reinterpret_cast<const IntoMethod*>(data);
+
+	// On exception nothing is written and size is zero
+	auto* buffer = p->GetArgument<OutputBuffer*>(0);
+	MonoObject* result = nullptr;
+	if (CallInto(into, p, result))
+		WriteReturnBuffer(*into.method, *buffer, result);
+	else
+		buffer->size = 0;
+
+	ret->SetReturnPtr(buffer);
+}
+
+void CSharpLanguageModule::AssignReturn(const Method& method, const Parameters* p, MonoObject* result) {
+	auto* source = reinterpret_cast<MonoArray*>(result);
+	switch (method.retType.type) {
+		case ValueType::String:
+			MonoStringToUTF8(reinterpret_cast<MonoString*>(result), *p->GetArgument<std::string*>(0));
+			break;
 		case ValueType::ArrayBool:
-			FreeMemory<std::vector<bool>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<bool>*>(0));
 			break;
 		case ValueType::ArrayChar8:
-			FreeMemory<std::vector<char>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<char>*>(0));
 			break;
 		case ValueType::ArrayChar16:
-			FreeMemory<std::vector<char16_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<char16_t>*>(0));
 			break;
 		case ValueType::ArrayInt8:
-			FreeMemory<std::vector<int16_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<int8_t>*>(0));
 			break;
 		case ValueType::ArrayInt16:
-			FreeMemory<std::vector<int16_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<int16_t>*>(0));
 			break;
 		case ValueType::ArrayInt32:
-			FreeMemory<std::vector<int32_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<int32_t>*>(0));
 			break;
 		case ValueType::ArrayInt64:
-			FreeMemory<std::vector<int64_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<int64_t>*>(0));
 			break;
 		case ValueType::ArrayUInt8:
-			FreeMemory<std::vector<uint8_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<uint8_t>*>(0));
 			break;
 		case ValueType::ArrayUInt16:
-			FreeMemory<std::vector<uint16_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<uint16_t>*>(0));
 			break;
 		case ValueType::ArrayUInt32:
-			FreeMemory<std::vector<uint32_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<uint32_t>*>(0));
 			break;
 		case ValueType::ArrayUInt64:
-			FreeMemory<std::vector<uint64_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<uint64_t>*>(0));
 			break;
 		case ValueType::ArrayPointer:
-			FreeMemory<std::vector<uintptr_t>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<uintptr_t>*>(0));
 			break;
 		case ValueType::ArrayFloat:
-			FreeMemory<std::vector<float>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<float>*>(0));
 			break;
 		case ValueType::ArrayDouble:
-			FreeMemory<std::vector<double>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<double>*>(0));
 			break;
 		case ValueType::ArrayString:
-			FreeMemory<std::vector<std::string>>(args[i++]);
+			MonoArrayToVector(source, *p->GetArgument<std::vector<std::string>*>(0));
 			break;
 		default:
+			std::puts("Unsupported types!\n");
+			std::terminate();
 			break;
 	}
 }
 
-// Call from C++ to C#
-void CSharpLanguageModule::InternalCall(const Method* method, void* data, const Parameters* p, uint8_t count, const ReturnValue* ret) {
-	const auto& [monoMethod, monoObject] = *reinterpret_cast<ExportMethod*>(data);
-
-	/// We not create param vector, and use Parameters* params directly if passing primitives
-	bool hasRefs = false;
-	bool hasRet = ValueTypeIsHiddenObjectParam(method->retType.type);
+void CSharpLanguageModule::WriteReturnBuffer(const Method& method, OutputBuffer& buffer, MonoObject* result) {
+	auto* source = reinterpret_cast<MonoArray*>(result);
+	switch (method.retType.type) {
+		case ValueType::String: {
+			// Conversion goes through per-thread scratch string which keeps its capacity
+			thread_local std::string scratch;
+			MonoStringToUTF8(reinterpret_cast<MonoString*>(result), scratch);
+			buffer.size = scratch.size();
+			std::memcpy(buffer.data, scratch.data(), std::min(scratch.size(), buffer.capacity));
+			break;
+		}
+		case ValueType::ArrayBool:
+			MonoArrayToBuffer<bool>(source, buffer);
+			break;
+		case ValueType::ArrayChar8:
+			MonoArrayToBuffer<char>(source, buffer);
+			break;
+		case ValueType::ArrayChar16:
+			MonoArrayToBuffer<char16_t>(source, buffer);
+			break;
+		case ValueType::ArrayInt8:
+			MonoArrayToBuffer<int8_t>(source, buffer);
+			break;
+		case ValueType::ArrayInt16:
+			MonoArrayToBuffer<int16_t>(source, buffer);
+			break;
+		case ValueType::ArrayInt32:
+			MonoArrayToBuffer<int32_t>(source, buffer);
+			break;
+		case ValueType::ArrayInt64:
+			MonoArrayToBuffer<int64_t>(source, buffer);
+			break;
+		case ValueType::ArrayUInt8:
+			MonoArrayToBuffer<uint8_t>(source, buffer);
+			break;
+		case ValueType::ArrayUInt16:
+			MonoArrayToBuffer<uint16_t>(source, buffer);
+			break;
+		case ValueType::ArrayUInt32:
+			MonoArrayToBuffer<uint32_t>(source, buffer);
+			break;
+		case ValueType::ArrayUInt64:
+			MonoArrayToBuffer<uint64_t>(source, buffer);
+			break;
+		case ValueType::ArrayPointer:
+			MonoArrayToBuffer<uintptr_t>(source, buffer);
+			break;
+		case ValueType::ArrayFloat:
+			MonoArrayToBuffer<float>(source, buffer);
+			break;
+		case ValueType::ArrayDouble:
+			MonoArrayToBuffer<double>(source, buffer);
+			break;
+		default:
+			std::puts("Unsupported types!\n");
+			std::terminate();
+			break;
+	}
+}
 
-	ArgumentList args;
-	args.reserve(hasRet ? count - 1 : count);
+template<typename T>
+T& ColumnAt(MonoArray* column, size_t row) {
+	return *reinterpret_cast<T*>(mono_array_addr_with_size(column, sizeof(T), row));
+}
 
-	SetParams(method, p, count, hasRet, hasRefs, args);
+// Call from C# to C++ once per row of argument columns
+MonoArray* CSharpLanguageModule::InvokeBatch(MonoString* name, MonoArray* columns) {
+	std::string funcName = MonoStringToUTF8(name);
 
-	MonoObject* exception = nullptr;
-	MonoObject* result = mono_runtime_invoke(monoMethod, monoObject, args.data(), &exception);
-	if (exception) {
-		HandleException(exception, nullptr);
-		ret->SetReturnPtr(uintptr_t{});
-		return;
+	const ImportMethod* found = nullptr;
+	{
+		std::shared_lock lock(g_monolm._importMutex);
+		auto it = g_monolm._importMethods.find(funcName);
+		if (it != g_monolm._importMethods.end())
+			found = &std::get<ImportMethod>(*it);
+	}
+	if (!found) {
+		g_monolm._provider->Log(std::format(LOG_PREFIX "Batch: method '{}' is not imported", funcName), Severity::Error);
+		return nullptr;
 	}
 
-	SetReferences(method, p, count, hasRet, hasRefs, args);
+	const auto& import = *found;
+	const Method* method = import.method;
 
-	SetReturn(method, p, ret, result);
-}
+	const auto& retType = method->retType;
+	bool supported = !retType.ref && (retType.type == ValueType::Void || GetColumnClass(retType.type)) && !method->paramTypes.empty();
+	for (const auto& param : method->paramTypes) {
+		supported &= !param.ref && GetColumnClass(param.type);
+	}
+	if (!supported) {
+		g_monolm._provider->Log(std::format(LOG_PREFIX "Batch: method '{}' has unsupported signature, only primitives and strings by value are allowed", funcName), Severity::Error);
+		return nullptr;
+	}
 
-// Call from C++ to C#
-void CSharpLanguageModule::DelegateCall(const Method* method, void* data, const Parameters* p, uint8_t count, const ReturnValue* ret) {
-	auto* monoDelegate = reinterpret_cast<MonoObject*>(data);
+	size_t paramCount = method->paramTypes.size();
+	if (!columns || mono_array_length(columns) != paramCount) {
+		g_monolm._provider->Log(std::format(LOG_PREFIX "Batch: method '{}' expects {} columns", funcName, paramCount), Severity::Error);
+		return nullptr;
+	}
 
-	/// We not create param vector, and use Parameters* params directly if passing primitives
-	bool hasRefs = false;
-	bool hasRet = ValueTypeIsHiddenObjectParam(method->retType.type);
+	// Validate columns once, rows are read without checks
+	InlineVector<MonoArray*, 16> sources;
+	sources.reserve(paramCount);
+	size_t rows = 0;
+	for (size_t i = 0; i < paramCount; ++i) {
+		auto* column = mono_array_get(columns, MonoArray*, i);
+		if (!column || mono_class_get_element_class(mono_object_get_class(reinterpret_cast<MonoObject*>(column))) != GetColumnClass(method->paramTypes[i].type) || (i && mono_array_length(column) != rows)) {
+			g_monolm._provider->Log(std::format(LOG_PREFIX "Batch: method '{}' has invalid column {}", funcName, i), Severity::Error);
+			return nullptr;
+		}
+		rows = mono_array_length(column);
+		sources.push_back(column);
+	}
 
-	ArgumentList args;
-	args.reserve(hasRet ? count - 1 : count);
+	MonoArray* results = retType.type != ValueType::Void ? g_monolm.CreateArray(GetColumnClass(retType.type), rows) : nullptr;
 
-	SetParams(method, p, count, hasRet, hasRefs, args);
+	Arena& arena = CallContext::Get().GetArena();
+	auto func = import.thunk.GetFunction();
+	bool hasRet = retType.type == ValueType::String;
 
-	MonoObject* exception = nullptr;
-	MonoObject* result = mono_runtime_delegate_invoke(monoDelegate, args.data(), &exception);
-	if (exception) {
-		HandleException(exception, nullptr);
-		ret->SetReturnPtr(uintptr_t{});
-		return;
-	}
+	std::array<NativeSlot, std::numeric_limits<uint8_t>::max() + 1> slots;
 
-	SetReferences(method, p, count, hasRet, hasRefs, args);
+	for (size_t row = 0; row < rows; ++row) {
+		Arena::Scope scope(arena);
+		ArgumentList args;
+		uint8_t n = 0;
 
-	SetReturn(method, p, ret, result);
-}
+		std::string* storage = nullptr;
+		if (hasRet) {
+			storage = static_cast<std::string*>(AllocateMemory<std::string>(arena, args));
+			StoreSlot(slots[n++], storage);
+		}
 
-void CSharpLanguageModule::SetParams(const Method* method, const Parameters* p, uint8_t count, bool hasRet, bool& hasRefs, ArgumentList& args) {
-	for (uint8_t i = hasRet, j = 0; i < count; ++i, ++j) {
-		void* arg;
-		const auto& param = method->paramTypes[j];
-		if (param.ref) {
-			switch (param.type) {
+		for (size_t i = 0; i < paramCount; ++i) {
+			MonoArray* column = sources[i];
+			auto& slot = slots[n++];
+			switch (method->paramTypes[i].type) {
 				case ValueType::Bool:
-					arg = p->GetArgument<bool*>(i);
+					StoreSlot(slot, ColumnAt<bool>(column, row));
 					break;
 				case ValueType::Char8:
-					arg = new char16_t(static_cast<char16_t>(*p->GetArgument<char*>(i)));
+					StoreSlot(slot, static_cast<char>(ColumnAt<char16_t>(column, row)));
 					break;
 				case ValueType::Char16:
-					arg = p->GetArgument<char16_t*>(i);
+					StoreSlot(slot, ColumnAt<char16_t>(column, row));
 					break;
 				case ValueType::Int8:
-					arg = p->GetArgument<int8_t*>(i);
+					StoreSlot(slot, ColumnAt<int8_t>(column, row));
 					break;
 				case ValueType::Int16:
-					arg = p->GetArgument<int16_t*>(i);
+					StoreSlot(slot, ColumnAt<int16_t>(column, row));
 					break;
 				case ValueType::Int32:
-					arg = p->GetArgument<int32_t*>(i);
+					StoreSlot(slot, ColumnAt<int32_t>(column, row));
 					break;
 				case ValueType::Int64:
-					arg = p->GetArgument<int64_t*>(i);
+					StoreSlot(slot, ColumnAt<int64_t>(column, row));
 					break;
 				case ValueType::UInt8:
-					arg = p->GetArgument<uint8_t*>(i);
+					StoreSlot(slot, ColumnAt<uint8_t>(column, row));
 					break;
 				case ValueType::UInt16:
-					arg = p->GetArgument<uint16_t*>(i);
+					StoreSlot(slot, ColumnAt<uint16_t>(column, row));
 					break;
 				case ValueType::UInt32:
-					arg = p->GetArgument<uint32_t*>(i);
+					StoreSlot(slot, ColumnAt<uint32_t>(column, row));
 					break;
 				case ValueType::UInt64:
-					arg = p->GetArgument<uint64_t*>(i);
+					StoreSlot(slot, ColumnAt<uint64_t>(column, row));
 					break;
 				case ValueType::Pointer:
-					arg = p->GetArgument<void**>(i);
+					StoreSlot(slot, ColumnAt<uintptr_t>(column, row));
 					break;
 				case ValueType::Float:
-					arg = p->GetArgument<float*>(i);
+					StoreSlot(slot, ColumnAt<float>(column, row));
 					break;
 				case ValueType::Double:
-					arg = p->GetArgument<double*>(i);
-					break;
-				case ValueType::Vector2:
-					arg = p->GetArgument<Vector2*>(i);
-					break;
-				case ValueType::Vector3:
-					arg = p->GetArgument<Vector3*>(i);
-					break;
-				case ValueType::Vector4:
-					arg = p->GetArgument<Vector4*>(i);
-					break;
-				case ValueType::Matrix4x4:
-					arg = p->GetArgument<Matrix4x4*>(i);
-					break;
-				case ValueType::Function:
-					arg = g_monolm.CreateDelegate(p->GetArgument<void*>(i), *param.prototype);
+					StoreSlot(slot, ColumnAt<double>(column, row));
 					break;
 				case ValueType::String:
-					arg = new MonoString*[1]{ g_monolm.CreateString(*p->GetArgument<std::string*>(i)) };
-					break;
-				case ValueType::ArrayBool:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<bool>(*p->GetArgument<std::vector<bool>*>(i), mono_get_byte_class()) };
-					break;
-				case ValueType::ArrayChar8:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<char>(*p->GetArgument<std::vector<char>*>(i), mono_get_char_class()) };
-				 	break;
-				case ValueType::ArrayChar16:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<char16_t>(*p->GetArgument<std::vector<char16_t>*>(i), mono_get_char_class()) };
-					break;
-				case ValueType::ArrayInt8:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<int8_t>(*p->GetArgument<std::vector<int8_t>*>(i), mono_get_sbyte_class()) };
-					break;
-				case ValueType::ArrayInt16:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<int16_t>(*p->GetArgument<std::vector<int16_t>*>(i), mono_get_int16_class()) };
-					break;
-				case ValueType::ArrayInt32:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<int32_t>(*p->GetArgument<std::vector<int32_t>*>(i), mono_get_int32_class()) };
-					break;
-				case ValueType::ArrayInt64:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<int64_t>(*p->GetArgument<std::vector<int64_t>*>(i), mono_get_int64_class()) };
-					break;
-				case ValueType::ArrayUInt8:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<uint8_t>(*p->GetArgument<std::vector<uint8_t>*>(i), mono_get_byte_class()) };
-					break;
-				case ValueType::ArrayUInt16:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<uint16_t>(*p->GetArgument<std::vector<uint16_t>*>(i), mono_get_uint16_class()) };
-					break;
-				case ValueType::ArrayUInt32:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<uint32_t>(*p->GetArgument<std::vector<uint32_t>*>(i), mono_get_uint32_class()) };
-					break;
-				case ValueType::ArrayUInt64:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<uint64_t>(*p->GetArgument<std::vector<uint64_t>*>(i), mono_get_uint64_class()) };
-					break;
-				case ValueType::ArrayPointer:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<uintptr_t>(*p->GetArgument<std::vector<uintptr_t>*>(i), mono_get_intptr_class()) };
-					break;
-				case ValueType::ArrayFloat:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<float>(*p->GetArgument<std::vector<float>*>(i), mono_get_single_class()) };
-					break;
-				case ValueType::ArrayDouble:
-					arg = new MonoArray*[1]{ g_monolm.CreateArrayT<double>(*p->GetArgument<std::vector<double>*>(i), mono_get_double_class()) };
-					break;
-				case ValueType::ArrayString:
-					arg = new MonoArray*[1]{ g_monolm.CreateStringArray(*p->GetArgument<std::vector<std::string>*>(i)) };
+					StoreSlot(slot, MonoStringToArg(ColumnAt<MonoString*>(column, row), arena, args));
 					break;
 				default:
 					std::puts("Unsupported types!\n");
 					std::terminate();
 					break;
 			}
-			hasRefs |= true;
-		} else {
-			switch (param.type) {
-				case ValueType::Bool:
-				case ValueType::Char16:
-				case ValueType::Int8:
-				case ValueType::Int16:
-				case ValueType::Int32:
-				case ValueType::Int64:
-				case ValueType::UInt8:
-				case ValueType::UInt16:
-				case ValueType::UInt32:
-				case ValueType::UInt64:
-				case ValueType::Pointer:
-				case ValueType::Float:
-				case ValueType::Double:
-					arg = p->GetArgumentPtr(i);
-					break;
-				case ValueType::Vector2:
-					arg = p->GetArgument<Vector2*>(i);
-					break;
-				case ValueType::Vector3:
-					arg = p->GetArgument<Vector3*>(i);
-					break;
-				case ValueType::Vector4:
-					arg = p->GetArgument<Vector4*>(i);
-					break;
-				case ValueType::Matrix4x4:
-					arg = p->GetArgument<Matrix4x4*>(i);
-					break;
-				case ValueType::Char8:
-					arg = new char16_t(static_cast<char16_t>(p->GetArgument<char>(i)));
-					break;
-				case ValueType::Function:
-					arg = g_monolm.CreateDelegate(p->GetArgument<void*>(i), *param.prototype);
-					break;
-				case ValueType::String:
-					arg = g_monolm.CreateString(*p->GetArgument<std::string*>(i));
-					break;
-				case ValueType::ArrayBool:
-					arg = g_monolm.CreateArrayT<bool>(*p->GetArgument<std::vector<bool>*>(i), mono_get_byte_class());
-					break;
-				case ValueType::ArrayChar8:
-					arg = g_monolm.CreateArrayT<char>(*p->GetArgument<std::vector<char>*>(i), mono_get_char_class());
-					break;
-				case ValueType::ArrayChar16:
-					arg = g_monolm.CreateArrayT<char16_t>(*p->GetArgument<std::vector<char16_t>*>(i), mono_get_char_class());
-					break;
-				case ValueType::ArrayInt8:
-					arg = g_monolm.CreateArrayT<int8_t>(*p->GetArgument<std::vector<int8_t>*>(i), mono_get_sbyte_class());
-					break;
-				case ValueType::ArrayInt16:
-					arg = g_monolm.CreateArrayT<int16_t>(*p->GetArgument<std::vector<int16_t>*>(i), mono_get_int16_class());
-					break;
-				case ValueType::ArrayInt32:
-					arg = g_monolm.CreateArrayT<int32_t>(*p->GetArgument<std::vector<int32_t>*>(i), mono_get_int32_class());
-					break;
-				case ValueType::ArrayInt64:
-					arg = g_monolm.CreateArrayT<int64_t>(*p->GetArgument<std::vector<int64_t>*>(i), mono_get_int64_class());
-					break;
-				case ValueType::ArrayUInt8:
-					arg = g_monolm.CreateArrayT<uint8_t>(*p->GetArgument<std::vector<uint8_t>*>(i), mono_get_byte_class());
-					break;
-				case ValueType::ArrayUInt16:
-					arg = g_monolm.CreateArrayT<uint16_t>(*p->GetArgument<std::vector<uint16_t>*>(i), mono_get_uint16_class());
-					break;
-				case ValueType::ArrayUInt32:
-					arg = g_monolm.CreateArrayT<uint32_t>(*p->GetArgument<std::vector<uint32_t>*>(i), mono_get_uint32_class());
-					break;
-				case ValueType::ArrayUInt64:
-					arg = g_monolm.CreateArrayT<uint64_t>(*p->GetArgument<std::vector<uint64_t>*>(i), mono_get_uint64_class());
-					break;
-				case ValueType::ArrayPointer:
-					arg = g_monolm.CreateArrayT<uintptr_t>(*p->GetArgument<std::vector<uintptr_t>*>(i), mono_get_intptr_class());
-					break;
-				case ValueType::ArrayFloat:
-					arg = g_monolm.CreateArrayT<float>(*p->GetArgument<std::vector<float>*>(i), mono_get_single_class());
-					break;
-				case ValueType::ArrayDouble:
-					arg = g_monolm.CreateArrayT<double>(*p->GetArgument<std::vector<double>*>(i), mono_get_double_class());
-					break;
-				case ValueType::ArrayString:
-					arg = g_monolm.CreateStringArray(*p->GetArgument<std::vector<std::string>*>(i));
-					break;
-				default:
-					std::puts("Unsupported types!\n");
-					std::terminate();
-					break;
-			}
-			// @TODO Temp HACK
-			hasRefs |= (param.type == ValueType::Char8);
 		}
-		args.push_back(arg);
-	}
-}
 
-void CSharpLanguageModule::SetReferences(const Method* method, const Parameters* p, uint8_t count, bool hasRet, bool hasRefs, const ArgumentList& args) {
-	if (hasRefs) {
-		for (uint8_t i = hasRet, j = 0; i < count; ++i, ++j) {
-			const auto& param = method->paramTypes[j];
-			if (param.ref) {
-				switch (param.type) {
-					case ValueType::Char8: {
-						auto* source = reinterpret_cast<char16_t*>(args[j]);
-						auto* dest = p->GetArgument<char*>(i);
-						*dest = static_cast<char>(*source);
-						delete source;
-						break;
-					}
-					case ValueType::String: {
-						auto source = reinterpret_cast<MonoString**>(args[j]);
-						if (source != nullptr)  {
-							auto* dest = p->GetArgument<std::string*>(i);
-							*dest = MonoStringToUTF8(source[0]);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayBool: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<bool>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayChar8: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<char>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-					 	delete[] source;
-						break;
-					}
-					case ValueType::ArrayChar16: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<char16_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayInt8: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<int8_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayInt16: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<int16_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayInt32: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<int32_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayInt64: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<int64_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayUInt8: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<uint8_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayUInt16: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<uint16_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayUInt32: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<uint32_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayUInt64: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<uint64_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayPointer: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<uintptr_t>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayFloat: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<float>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayDouble: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<double>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					case ValueType::ArrayString: {
-						auto source = reinterpret_cast<MonoArray**>(args[j]);
-						if (source != nullptr) {
-							auto* dest = p->GetArgument<std::vector<std::string>*>(i);
-							MonoArrayToVector(source[0], *dest);
-						}
-						delete[] source;
-						break;
-					}
-					default:
-						break;
-				}
-			} else {
-				// @TODO Refactor this
-				if (param.type == ValueType::Char8) {
-					delete reinterpret_cast<char16_t*>(args[j]);
-				}
-			}
+		NativeSlot result{};
+		if (func) {
+			func(slots.data(), &result);
+		} else {
+			CallVirtMachine(method, import.addr, nullptr, nullptr, slots.data(), n, hasRet, result);
 		}
-	}
-}
 
-void CSharpLanguageModule::SetReturn(const Method* method, const Parameters* p, const ReturnValue* ret, MonoObject* result) {
-	if (result) {
-		switch (method->retType.type) {
-			case ValueType::Bool: {
-				bool val = *reinterpret_cast<bool*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+		switch (retType.type) {
+			case ValueType::Void:
 				break;
-			}
-			case ValueType::Char8: {
-				char16_t val = *reinterpret_cast<char16_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(static_cast<char>(val));
+			case ValueType::Bool:
+				ColumnAt<bool>(results, row) = LoadSlot<bool>(result);
 				break;
-			}
-			case ValueType::Char16: {
-				char16_t val = *reinterpret_cast<char16_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Char8:
+				ColumnAt<char16_t>(results, row) = static_cast<char16_t>(LoadSlot<char>(result));
 				break;
-			}
-			case ValueType::Int8: {
-				int8_t val = *reinterpret_cast<int8_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Char16:
+				ColumnAt<char16_t>(results, row) = LoadSlot<char16_t>(result);
 				break;
-			}
-			case ValueType::Int16: {
-				int16_t val = *reinterpret_cast<int16_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Int8:
+				ColumnAt<int8_t>(results, row) = LoadSlot<int8_t>(result);
 				break;
-			}
-			case ValueType::Int32: {
-				int32_t val = *reinterpret_cast<int32_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Int16:
+				ColumnAt<int16_t>(results, row) = LoadSlot<int16_t>(result);
 				break;
-			}
-			case ValueType::Int64: {
-				int64_t val = *reinterpret_cast<int64_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Int32:
+				ColumnAt<int32_t>(results, row) = LoadSlot<int32_t>(result);
 				break;
-			}
-			case ValueType::UInt8: {
-				uint8_t val = *reinterpret_cast<uint8_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Int64:
+				ColumnAt<int64_t>(results, row) = LoadSlot<int64_t>(result);
 				break;
-			}
-			case ValueType::UInt16: {
-				uint16_t val = *reinterpret_cast<uint16_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::UInt8:
+				ColumnAt<uint8_t>(results, row) = LoadSlot<uint8_t>(result);
 				break;
-			}
-			case ValueType::UInt32: {
-				uint32_t val = *reinterpret_cast<uint32_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::UInt16:
+				ColumnAt<uint16_t>(results, row) = LoadSlot<uint16_t>(result);
 				break;
-			}
-			case ValueType::UInt64: {
-				uint64_t val = *reinterpret_cast<uint64_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::UInt32:
+				ColumnAt<uint32_t>(results, row) = LoadSlot<uint32_t>(result);
 				break;
-			}
-			case ValueType::Pointer: {
-				uintptr_t val = *reinterpret_cast<uintptr_t*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::UInt64:
+				ColumnAt<uint64_t>(results, row) = LoadSlot<uint64_t>(result);
 				break;
-			}
-			case ValueType::Float: {
-				float val = *reinterpret_cast<float*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Pointer:
+				ColumnAt<uintptr_t>(results, row) = LoadSlot<uintptr_t>(result);
 				break;
-			}
-			case ValueType::Double: {
-				double val = *reinterpret_cast<double*>(mono_object_unbox(result));
-				ret->SetReturnPtr(val);
+			case ValueType::Float:
+				ColumnAt<float>(results, row) = LoadSlot<float>(result);
 				break;
-			}
-			case ValueType::Vector2: {
-				Vector2 source = *reinterpret_cast<Vector2*>(mono_object_unbox(result));
-				ret->SetReturnPtr(source);
+			case ValueType::Double:
+				ColumnAt<double>(results, row) = LoadSlot<double>(result);
 				break;
-			}
+			case ValueType::String:
+				mono_array_setref(results, row, g_monolm.CreateString(*storage));
+				break;
+			default:
+				std::puts("Unsupported types!\n");
+				std::terminate();
+				break;
+		}
+	}
+
+	return results;
+}
+
+// Call from C# to open a stream over a native producer export, elements are pulled chunk by chunk
+ArrayStream* CSharpLanguageModule::OpenArrayStream(MonoString* name, MonoReflectionType* elementType) {
+	std::string funcName = MonoStringToUTF8(name);
+
+	const ImportMethod* found = nullptr;
+	{
+		std::shared_lock lock(g_monolm._importMutex);
+		auto it = g_monolm._importMethods.find(funcName);
+		if (it != g_monolm._importMethods.end())
+			found = &std::get<ImportMethod>(*it);
+	}
+	if (!found) {
+		g_monolm._provider->Log(std::format(LOG_PREFIX "ArrayStream: method '{}' is not imported", funcName), Severity::Error);
+		return nullptr;
+	}
+
+	// uint64 (ptr64 buffer, uint64 offset, uint64 capacity)
+	const Method* method = found->method;
+	const auto& params = method->paramTypes;
+	bool supported = method->retType.type == ValueType::UInt64 && !method->retType.ref && params.size() == 3
+		&& params[0].type == ValueType::Pointer && params[1].type == ValueType::UInt64 && params[2].type == ValueType::UInt64
+		&& !params[0].ref && !params[1].ref && !params[2].ref;
+	if (!supported) {
+		g_monolm._provider->Log(std::format(LOG_PREFIX "ArrayStream: method '{}' is not a producer, expected uint64(ptr64, uint64, uint64)", funcName), Severity::Error);
+		return nullptr;
+	}
+
+	MonoClass* elementClass = mono_class_from_mono_type(mono_reflection_type_get_type(elementType));
+	return ArrayStream::Create(reinterpret_cast<ArrayStream::Producer>(found->addr), elementClass);
+}
+
+MonoClass* CSharpLanguageModule::GetColumnClass(ValueType type) {
+	switch (type) {
+		case ValueType::Bool:
+			return mono_get_boolean_class();
+		case ValueType::Char8:
+		case ValueType::Char16:
+			return mono_get_char_class();
+		case ValueType::Int8:
+			return mono_get_sbyte_class();
+		case ValueType::Int16:
+			return mono_get_int16_class();
+		case ValueType::Int32:
+			return mono_get_int32_class();
+		case ValueType::Int64:
+			return mono_get_int64_class();
+		case ValueType::UInt8:
+			return mono_get_byte_class();
+		case ValueType::UInt16:
+			return mono_get_uint16_class();
+		case ValueType::UInt32:
+			return mono_get_uint32_class();
+		case ValueType::UInt64:
+			return mono_get_uint64_class();
+		case ValueType::Pointer:
+			return mono_get_intptr_class();
+		case ValueType::Float:
+			return mono_get_single_class();
+		case ValueType::Double:
+			return mono_get_double_class();
+		case ValueType::String:
+			return mono_get_string_class();
+		default:
+			return nullptr;
+	}
+}
+
+void* CSharpLanguageModule::ArgumentValue(const MarshalOp&, const Parameters* p, uint8_t i, Arena&) {
+	return p->GetArgumentPtr(i);
+}
+
+// Primitives by reference, and vectors or matrices which native side always passes by pointer
+void* CSharpLanguageModule::ArgumentPointer(const MarshalOp&, const Parameters* p, uint8_t i, Arena&) {
+	return p->GetArgument<void*>(i);
+}
+
+template<bool Ref>
+void* CSharpLanguageModule::CharToArg(const MarshalOp&, const Parameters* p, uint8_t i, Arena& arena) {
+	if constexpr (Ref)
+		return arena.New<char16_t>(static_cast<char16_t>(*p->GetArgument<char*>(i)));
+	else
+		return arena.New<char16_t>(static_cast<char16_t>(p->GetArgument<char>(i)));
+}
+
+void* CSharpLanguageModule::DelegateToArg(const MarshalOp& op, const Parameters* p, uint8_t i, Arena&) {
+	return g_monolm.CreateDelegate(p->GetArgument<void*>(i), *op.prototype);
+}
+
+template<bool Ref>
+void* CSharpLanguageModule::StringToArg(const MarshalOp&, const Parameters* p, uint8_t i, Arena& arena) {
+	if constexpr (Ref)
+		return NewRefCell(arena, g_monolm.CreateString(*p->GetArgument<std::string*>(i)));
+	else
+		return g_monolm.CreateInternedString(*p->GetArgument<std::string*>(i));
+}
+
+template<typename T, bool Ref>
+void* CSharpLanguageModule::ArrayToArg(const MarshalOp& op, const Parameters* p, uint8_t i, Arena& arena) {
+	MonoArray* array;
+	if constexpr (std::is_same_v<T, std::string>)
+		array = g_monolm.CreateStringArray(*p->GetArgument<std::vector<std::string>*>(i));
+	else
+		array = g_monolm.CreateArrayT<T>(*p->GetArgument<std::vector<T>*>(i), op.klass);
+	if constexpr (Ref)
+		return NewRefCell(arena, array);
+	else
+		return array;
+}
+
+void* CSharpLanguageModule::UnsupportedArg(const MarshalOp&, const Parameters*, uint8_t, Arena&) {
+	std::puts("Unsupported types!\n");
+	std::terminate();
+}
+
+void CSharpLanguageModule::CharFromRef(const MarshalOp&, const Parameters* p, uint8_t i, void* arg) {
+	*p->GetArgument<char*>(i) = static_cast<char>(*reinterpret_cast<char16_t*>(arg));
+}
+
+void CSharpLanguageModule::StringFromRef(const MarshalOp&, const Parameters* p, uint8_t i, void* arg) {
+	auto source = reinterpret_cast<MonoString**>(arg);
+	if (source != nullptr && source[0] != source[1]) {
+		auto* dest = p->GetArgument<std::string*>(i);
+		*dest = MonoStringToUTF8(source[0]);
+	}
+}
+
+template<typename T>
+void CSharpLanguageModule::ArrayFromRef(const MarshalOp&, const Parameters* p, uint8_t i, void* arg) {
+	auto source = reinterpret_cast<MonoArray**>(arg);
+	if (source != nullptr) {
+		auto* dest = p->GetArgument<std::vector<T>*>(i);
+		if (source[0] != source[1] || !MonoArrayEquals(source[0], *dest))
+			MonoArrayToVector(source[0], *dest);
+	}
+}
+
+template<typename T, typename N>
+void CSharpLanguageModule::ResultValue(const Method*, const Parameters*, const ReturnValue* ret, MonoObject* result) {
+	ret->SetReturnPtr(static_cast<N>(*reinterpret_cast<T*>(mono_object_unbox(result))));
+}
+
+// Returned through the storage passed as the first native parameter
+template<typename T>
+void CSharpLanguageModule::ResultHidden(const Method*, const Parameters* p, const ReturnValue* ret, MonoObject* result) {
+	auto* source = reinterpret_cast<T*>(mono_object_unbox(result));
+	auto* dest = p->GetArgument<T*>(0);
+	*dest = *source;
+	ret->SetReturnPtr(dest);
+}
+
+void CSharpLanguageModule::ResultDelegate(const Method* method, const Parameters*, const ReturnValue* ret, MonoObject* result) {
+	auto* source = reinterpret_cast<MonoDelegate*>(result);
+	ret->SetReturnPtr(g_monolm.MonoDelegateToArg(source, *(method->retType.prototype)));
+}
+
+void CSharpLanguageModule::ResultString(const Method*, const Parameters* p, const ReturnValue* ret, MonoObject* result) {
+	auto* source = reinterpret_cast<MonoString*>(result);
+	auto* dest = p->GetArgument<std::string*>(0);
+	std::construct_at(dest, MonoStringToUTF8(source));
+	ret->SetReturnPtr(dest);
+}
+
+template<typename T>
+void CSharpLanguageModule::ResultArray(const Method*, const Parameters* p, const ReturnValue* ret, MonoObject* result) {
+	auto* source = reinterpret_cast<MonoArray*>(result);
+	auto* dest = p->GetArgument<std::vector<T>*>(0);
+	std::vector<T> storage;
+	MonoArrayToVector(source, storage);
+	std::construct_at(dest, std::move(storage));
+	ret->SetReturnPtr(dest);
+}
+
+void CSharpLanguageModule::UnsupportedResult(const Method*, const Parameters*, const ReturnValue*, MonoObject*) {
+	std::puts("Unsupported types!\n");
+	std::terminate();
+}
+
+template<typename N, typename T>
+void CSharpLanguageModule::ResultSlotValue(const ReturnValue* ret, uint64_t result) {
+	ret->SetReturnPtr(static_cast<T>(LoadSlot<N>(result)));
+}
+
+// Resolves every conversion of InternalCall and DelegateCall once, so the call itself does not switch on value types
+void CSharpLanguageModule::BindConverters(MarshalPlan& plan, const Method& method) {
+	switch (method.retType.type) {
+		case ValueType::Void:
+			break;
+		case ValueType::Bool:
+			plan.storeResult = &ResultValue<bool>;
+			plan.storeResultSlot = &ResultSlotValue<uint8_t, bool>;
+			break;
+		case ValueType::Char8:
+			plan.storeResult = &ResultValue<char16_t, char>;
+			plan.storeResultSlot = &ResultSlotValue<char16_t, char>;
+			break;
+		case ValueType::Char16:
+			plan.storeResult = &ResultValue<char16_t>;
+			plan.storeResultSlot = &ResultSlotValue<char16_t>;
+			break;
+		case ValueType::Int8:
+			plan.storeResult = &ResultValue<int8_t>;
+			plan.storeResultSlot = &ResultSlotValue<int8_t>;
+			break;
+		case ValueType::Int16:
+			plan.storeResult = &ResultValue<int16_t>;
+			plan.storeResultSlot = &ResultSlotValue<int16_t>;
+			break;
+		case ValueType::Int32:
+			plan.storeResult = &ResultValue<int32_t>;
+			plan.storeResultSlot = &ResultSlotValue<int32_t>;
+			break;
+		case ValueType::Int64:
+			plan.storeResult = &ResultValue<int64_t>;
+			plan.storeResultSlot = &ResultSlotValue<int64_t>;
+			break;
+		case ValueType::UInt8:
+			plan.storeResult = &ResultValue<uint8_t>;
+			plan.storeResultSlot = &ResultSlotValue<uint8_t>;
+			break;
+		case ValueType::UInt16:
+			plan.storeResult = &ResultValue<uint16_t>;
+			plan.storeResultSlot = &ResultSlotValue<uint16_t>;
+			break;
+		case ValueType::UInt32:
+			plan.storeResult = &ResultValue<uint32_t>;
+			plan.storeResultSlot = &ResultSlotValue<uint32_t>;
+			break;
+		case ValueType::UInt64:
+			plan.storeResult = &ResultValue<uint64_t>;
+			plan.storeResultSlot = &ResultSlotValue<uint64_t>;
+			break;
+		case ValueType::Pointer:
+			plan.storeResult = &ResultValue<uintptr_t>;
+			plan.storeResultSlot = &ResultSlotValue<uintptr_t>;
+			break;
+		case ValueType::Float:
+			plan.storeResult = &ResultValue<float>;
+			plan.storeResultSlot = &ResultSlotValue<float>;
+			break;
+		case ValueType::Double:
+			plan.storeResult = &ResultValue<double>;
+			plan.storeResultSlot = &ResultSlotValue<double>;
+			break;
+		case ValueType::Vector2:
+			plan.storeResult = &ResultValue<Vector2>;
+			break;
 #if MONOLM_PLATFORM_WINDOWS
-			case ValueType::Vector3: {
-				auto* source = reinterpret_cast<Vector3*>(mono_object_unbox(result));
-				auto* dest = p->GetArgument<Vector3*>(0);
-				*dest = *source;
-				ret->SetReturnPtr(dest);
-				break;
-			}
-			case ValueType::Vector4: {
-				auto* source = reinterpret_cast<Vector4*>(mono_object_unbox(result));
-				auto* dest = p->GetArgument<Vector4*>(0);
-				*dest = *source;
-				ret->SetReturnPtr(dest);
-				break;
-			}
+		case ValueType::Vector3:
+			plan.storeResult = &ResultHidden<Vector3>;
+			break;
+		case ValueType::Vector4:
+			plan.storeResult = &ResultHidden<Vector4>;
+			break;
 #else
-			case ValueType::Vector3: {
-				Vector3 source = *reinterpret_cast<Vector3*>(mono_object_unbox(result));
-				ret->SetReturnPtr(source);
-				break;
-			}
-			case ValueType::Vector4: {
-				Vector4 source = *reinterpret_cast<Vector4*>(mono_object_unbox(result));
-				ret->SetReturnPtr(source);
-				break;
-			}
+		case ValueType::Vector3:
+			plan.storeResult = &ResultValue<Vector3>;
+			break;
+		case ValueType::Vector4:
+			plan.storeResult = &ResultValue<Vector4>;
+			break;
 #endif
-			case ValueType::Matrix4x4: {
-				auto* source = reinterpret_cast<Matrix4x4*>(mono_object_unbox(result));
-				auto* dest = p->GetArgument<Matrix4x4*>(0);
-				*dest = *source;
-				ret->SetReturnPtr(dest);
-				break;
-			}
-			case ValueType::Function: {
-				auto* source = reinterpret_cast<MonoDelegate*>(result);
-				ret->SetReturnPtr(g_monolm.MonoDelegateToArg(source, *(method->retType.prototype)));
+		case ValueType::Matrix4x4:
+			plan.storeResult = &ResultHidden<Matrix4x4>;
+			break;
+		// MonoDelegate*
+		case ValueType::Function:
+			plan.storeResult = &ResultDelegate;
+			break;
+		// MonoString*
+		case ValueType::String:
+			plan.storeResult = &ResultString;
+			break;
+		// MonoArray*
+		case ValueType::ArrayBool:
+			plan.storeResult = &ResultArray<bool>;
+			break;
+		case ValueType::ArrayChar8:
+			plan.storeResult = &ResultArray<char>;
+			break;
+		case ValueType::ArrayChar16:
+			plan.storeResult = &ResultArray<char16_t>;
+			break;
+		case ValueType::ArrayInt8:
+			plan.storeResult = &ResultArray<int8_t>;
+			break;
+		case ValueType::ArrayInt16:
+			plan.storeResult = &ResultArray<int16_t>;
+			break;
+		case ValueType::ArrayInt32:
+			plan.storeResult = &ResultArray<int32_t>;
+			break;
+		case ValueType::ArrayInt64:
+			plan.storeResult = &ResultArray<int64_t>;
+			break;
+		case ValueType::ArrayUInt8:
+			plan.storeResult = &ResultArray<uint8_t>;
+			break;
+		case ValueType::ArrayUInt16:
+			plan.storeResult = &ResultArray<uint16_t>;
+			break;
+		case ValueType::ArrayUInt32:
+			plan.storeResult = &ResultArray<uint32_t>;
+			break;
+		case ValueType::ArrayUInt64:
+			plan.storeResult = &ResultArray<uint64_t>;
+			break;
+		case ValueType::ArrayPointer:
+			plan.storeResult = &ResultArray<uintptr_t>;
+			break;
+		case ValueType::ArrayFloat:
+			plan.storeResult = &ResultArray<float>;
+			break;
+		case ValueType::ArrayDouble:
+			plan.storeResult = &ResultArray<double>;
+			break;
+		case ValueType::ArrayString:
+			plan.storeResult = &ResultArray<std::string>;
+			break;
+		default:
+			plan.storeResult = &UnsupportedResult;
+			break;
+	}
+
+	for (auto& op : plan.params) {
+		switch (op.type) {
+			case ValueType::Bool:
+			case ValueType::Char16:
+			case ValueType::Int8:
+			case ValueType::Int16:
+			case ValueType::Int32:
+			case ValueType::Int64:
+			case ValueType::UInt8:
+			case ValueType::UInt16:
+			case ValueType::UInt32:
+			case ValueType::UInt64:
+			case ValueType::Pointer:
+			case ValueType::Float:
+			case ValueType::Double:
+				op.convert = op.ref ? &ArgumentPointer : &ArgumentValue;
 				break;
-			}
-			case ValueType::String: {
-				auto* source = reinterpret_cast<MonoString*>(result);
-				auto* dest = p->GetArgument<std::string*>(0);
-				std::construct_at(dest, MonoStringToUTF8(source));
-				ret->SetReturnPtr(dest);
+			case ValueType::Vector2:
+			case ValueType::Vector3:
+			case ValueType::Vector4:
+			case ValueType::Matrix4x4:
+				op.convert = &ArgumentPointer;
 				break;
-			}
-			case ValueType::ArrayBool: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<bool>*>(0);
-				std::vector<bool> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::Char8:
+				op.convert = op.ref ? &CharToArg<true> : &CharToArg<false>;
+				op.copyBack = &CharFromRef;
 				break;
-			}
-			case ValueType::ArrayChar8: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<char>*>(0);
-				std::vector<char> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::Function:
+				op.convert = &DelegateToArg;
 				break;
-			}
-			case ValueType::ArrayChar16: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<char16_t>*>(0);
-				std::vector<char16_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::String:
+				op.convert = op.ref ? &StringToArg<true> : &StringToArg<false>;
+				op.copyBack = &StringFromRef;
 				break;
-			}
-			case ValueType::ArrayInt8: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<int8_t>*>(0);
-				std::vector<int8_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayBool:
+				op.convert = op.ref ? &ArrayToArg<bool, true> : &ArrayToArg<bool, false>;
+				op.copyBack = &ArrayFromRef<bool>;
 				break;
-			}
-			case ValueType::ArrayInt16: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<int16_t>*>(0);
-				std::vector<int16_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayChar8:
+				op.convert = op.ref ? &ArrayToArg<char, true> : &ArrayToArg<char, false>;
+				op.copyBack = &ArrayFromRef<char>;
 				break;
-			}
-			case ValueType::ArrayInt32: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<int32_t>*>(0);
-				std::vector<int32_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayChar16:
+				op.convert = op.ref ? &ArrayToArg<char16_t, true> : &ArrayToArg<char16_t, false>;
+				op.copyBack = &ArrayFromRef<char16_t>;
 				break;
-			}
-			case ValueType::ArrayInt64: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<int64_t>*>(0);
-				std::vector<int64_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayInt8:
+				op.convert = op.ref ? &ArrayToArg<int8_t, true> : &ArrayToArg<int8_t, false>;
+				op.copyBack = &ArrayFromRef<int8_t>;
 				break;
-			}
-			case ValueType::ArrayUInt8: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<uint8_t>*>(0);
-				std::vector<uint8_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayInt16:
+				op.convert = op.ref ? &ArrayToArg<int16_t, true> : &ArrayToArg<int16_t, false>;
+				op.copyBack = &ArrayFromRef<int16_t>;
 				break;
-			}
-			case ValueType::ArrayUInt16: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<uint16_t>*>(0);
-				std::vector<uint16_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayInt32:
+				op.convert = op.ref ? &ArrayToArg<int32_t, true> : &ArrayToArg<int32_t, false>;
+				op.copyBack = &ArrayFromRef<int32_t>;
 				break;
-			}
-			case ValueType::ArrayUInt32: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<uint32_t>*>(0);
-				std::vector<uint32_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayInt64:
+				op.convert = op.ref ? &ArrayToArg<int64_t, true> : &ArrayToArg<int64_t, false>;
+				op.copyBack = &ArrayFromRef<int64_t>;
 				break;
-			}
-			case ValueType::ArrayUInt64: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<uint64_t>*>(0);
-				std::vector<uint64_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayUInt8:
+				op.convert = op.ref ? &ArrayToArg<uint8_t, true> : &ArrayToArg<uint8_t, false>;
+				op.copyBack = &ArrayFromRef<uint8_t>;
 				break;
-			}
-			case ValueType::ArrayPointer: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<uintptr_t>*>(0);
-				std::vector<uintptr_t> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayUInt16:
+				op.convert = op.ref ? &ArrayToArg<uint16_t, true> : &ArrayToArg<uint16_t, false>;
+				op.copyBack = &ArrayFromRef<uint16_t>;
 				break;
-			}
-			case ValueType::ArrayFloat: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<float>*>(0);
-				std::vector<float> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayUInt32:
+				op.convert = op.ref ? &ArrayToArg<uint32_t, true> : &ArrayToArg<uint32_t, false>;
+				op.copyBack = &ArrayFromRef<uint32_t>;
 				break;
-			}
-			case ValueType::ArrayDouble: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<double>*>(0);
-				std::vector<double> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayUInt64:
+				op.convert = op.ref ? &ArrayToArg<uint64_t, true> : &ArrayToArg<uint64_t, false>;
+				op.copyBack = &ArrayFromRef<uint64_t>;
 				break;
-			}
-			case ValueType::ArrayString: {
-				auto* source = reinterpret_cast<MonoArray*>(result);
-				auto* dest = p->GetArgument<std::vector<std::string>*>(0);
-				std::vector<std::string> storage;
-				MonoArrayToVector(source, storage);
-				std::construct_at(dest, std::move(storage));
-				ret->SetReturnPtr(dest);
+			case ValueType::ArrayPointer:
+				op.convert = op.ref ? &ArrayToArg<uintptr_t, true> : &ArrayToArg<uintptr_t, false>;
+				op.copyBack = &ArrayFromRef<uintptr_t>;
 				break;
-			}
-			default:
-				std::puts("Unsupported types!\n");
-				std::terminate();
+			case ValueType::ArrayFloat:
+				op.convert = op.ref ? &ArrayToArg<float, true> : &ArrayToArg<float, false>;
+				op.copyBack = &ArrayFromRef<float>;
 				break;
-		}
-	} else {
-		switch (method->retType.type) {
-			case ValueType::Invalid:
-				std::puts("Unsupported types!\n");
-				std::terminate();
+			case ValueType::ArrayDouble:
+				op.convert = op.ref ? &ArrayToArg<double, true> : &ArrayToArg<double, false>;
+				op.copyBack = &ArrayFromRef<double>;
 				break;
-			case ValueType::Void:
+			case ValueType::ArrayString:
+				op.convert = op.ref ? &ArrayToArg<std::string, true> : &ArrayToArg<std::string, false>;
+				op.copyBack = &ArrayFromRef<std::string>;
 				break;
 			default:
-				ret->SetReturnPtr(uintptr_t{});
+				op.convert = &UnsupportedArg;
 				break;
 		}
+
+		if (op.stride)
+			op.convert = &NativeStructToArg;
+		else if (op.view != ViewKind::None)
+			op.convert = &NativeViewToArg;
+	}
+
+	// Write back list holds copies of the ops, refresh them from the bound ones
+	for (auto& ref : plan.writeBack) {
+		ref = plan.params[ref.index];
+	}
+}
+
+void CSharpLanguageModule::SetParams(const MarshalPlan& plan, const Parameters* p, Arena& arena, ArgumentList& args) {
+	for (const auto& op : plan.params) {
+		args.push_back(op.convert(op, p, static_cast<uint8_t>(op.index + plan.hiddenRet), arena));
+	}
+}
+
+void CSharpLanguageModule::SetReferences(const MarshalPlan& plan, const Parameters* p, const ArgumentList& args) {
+	for (const auto& op : plan.writeBack) {
+		if (op.copyBack)
+			op.copyBack(op, p, static_cast<uint8_t>(op.index + plan.hiddenRet), args[op.index]);
 	}
 }
 
+void CSharpLanguageModule::SetReturn(const MarshalPlan& plan, const Method* method, const Parameters* p, const ReturnValue* ret, MonoObject* result) {
+	if (!plan.storeResult)
+		return;
+	if (result)
+		plan.storeResult(method, p, ret, result);
+	else
+		ret->SetReturnPtr(uintptr_t{});
+}
+
+void CSharpLanguageModule::SetReturnSlot(const MarshalPlan& plan, const Method* method, const Parameters* p, const ReturnValue* ret, const NativeSlot& result) {
+	// Void, delegates, strings and arrays are managed references, same as runtime invoke result
+	if (plan.storeResultSlot)
+		plan.storeResultSlot(ret, result);
+	else
+		SetReturn(plan, method, p, ret, LoadSlot<MonoObject*>(result));
+}
+
 LoadResult CSharpLanguageModule::OnPluginLoad(const IPlugin& plugin) {
 	MonoImageOpenStatus status = MONO_IMAGE_IMAGE_INVALID;
 
@@ -2182,6 +2926,9 @@ LoadResult CSharpLanguageModule::OnPluginLoad(const IPlugin& plugin) {
 
 		bool methodFail = false;
 
+		// Parameters which are user blittable structs, vector or jagged arrays and views, they need own marshalling plan
+		std::vector<MarshalOp> structOps;
+
 		size_t i = 0;
 		void* iter = nullptr;
 		while (MonoType* type = mono_signature_get_params(sig, &iter)) {
@@ -2195,6 +2942,22 @@ LoadResult CSharpLanguageModule::OnPluginLoad(const IPlugin& plugin) {
 				}
 			}
 
+			if (paramType == ValueType::Invalid && i < method.paramTypes.size()) {
+				std::string error;
+				MarshalOp op{};
+				op.index = static_cast<uint8_t>(i);
+				paramType = GetViewParamType(type, method.paramTypes[i], op, error);
+				if (paramType == ValueType::Invalid && error.empty())
+					paramType = GetStructParamType(type, method.paramTypes[i], op, error);
+				if (!error.empty()) {
+					methodFail = true;
+					methodErrors.emplace_back(std::format("Parameter at index '{}' of method '{}': {}", i, method.funcName, error));
+					continue;
+				}
+				if (paramType != ValueType::Invalid)
+					structOps.push_back(op);
+			}
+
 			if (paramType == ValueType::Invalid) {
 				methodFail = true;
 				methodErrors.emplace_back(std::format("Parameter at index '{}' of method '{}' not supported '{}'", i, method.funcName, paramTypeName));
@@ -2213,13 +2976,64 @@ LoadResult CSharpLanguageModule::OnPluginLoad(const IPlugin& plugin) {
 				continue;
 			}
 
+			// Vector and matrix arrays, element class replaces float in own plan
+			if (paramType == ValueType::ArrayFloat && mono_class_get_rank(mono_class_from_mono_type(type)) == 1) {
+				MonoClass* elementClass = mono_class_get_element_class(mono_class_from_mono_type(type));
+				if (elementClass != mono_get_single_class()) {
+					MarshalOp op{};
+					op.index = static_cast<uint8_t>(i);
+					op.klass = elementClass;
+					structOps.push_back(op);
+				}
+			}
+
+			// Jagged arrays, row class replaces byte in own plan
+			if (paramType == ValueType::ArrayUInt8 && !method.paramTypes[i].ref && mono_class_get_rank(mono_class_from_mono_type(type)) == 1) {
+				MonoClass* rowClass = mono_class_get_element_class(mono_class_from_mono_type(type));
+				if (mono_class_get_rank(rowClass) == 1) {
+					MarshalOp op{};
+					op.index = static_cast<uint8_t>(i);
+					op.klass = rowClass;
+					structOps.push_back(op);
+				}
+			}
+
 			i++;
 		}
 
 		if (methodFail)
 			continue;
 
-		auto exportMethod = std::make_unique<ExportMethod>(monoMethod, monoInstance);
+		const MarshalPlan* plan = &GetMarshalPlan(method);
+		if (!structOps.empty()) {
+			auto& structPlan = _structPlans.emplace_back(std::make_unique<MarshalPlan>(*plan));
+			for (const auto& op : structOps) {
+				auto& target = structPlan->params[op.index];
+				target.stride = op.stride;
+				target.size = op.size;
+				target.view = op.view;
+				if (op.klass) {
+					target.klass = op.klass;
+					for (auto& ref : structPlan->writeBack) {
+						if (ref.index == op.index)
+							ref.klass = op.klass;
+					}
+				}
+			}
+			// Views work on native container directly, nothing to copy back
+			std::erase_if(structPlan->writeBack, [&structOps](const MarshalOp& ref) {
+				return std::any_of(structOps.begin(), structOps.end(), [&ref](const MarshalOp& op) { return op.index == ref.index && op.view != ViewKind::None; });
+			});
+			BindConverters(*structPlan, method);
+			plan = structPlan.get();
+		}
+
+		auto exportMethod = std::make_unique<ExportMethod>(monoMethod, monoInstance, plan, CallThunk(_rt));
+		// Structs by value have platform specific conventions in the thunk, keep runtime invoke for them
+		bool hasStructs = std::any_of(structOps.begin(), structOps.end(), [](const MarshalOp& op) { return op.stride != 0; });
+		if (hasStructs || !CreateManagedThunk(exportMethod->thunk, monoMethod, monoInstance != nullptr, method)) {
+			_provider->Log(std::format(LOG_PREFIX "Method '{}' will be called through runtime invoke: {}", method.funcName, exportMethod->thunk.GetError()), Severity::Verbose);
+		}
 
 		Function function(_rt);
 		void* methodAddr = function.GetJitFunc(method, &InternalCall, exportMethod.get());
@@ -2227,7 +3041,18 @@ LoadResult CSharpLanguageModule::OnPluginLoad(const IPlugin& plugin) {
 			methodErrors.emplace_back(std::format("Method JIT generation error: ", function.GetError()));
 			continue;
 		}
-		_functions.emplace(exportMethod.get(), std::move(function));
+		{
+			std::unique_lock lock(_functionMutex);
+			_functions.emplace(exportMethod.get(), std::move(function));
+		}
+		{
+			std::lock_guard lock(_batchMutex);
+			_batchMethods.emplace(methodAddr, std::make_unique<BatchMethod>(exportMethod.get(), &method));
+		}
+		{
+			std::lock_guard lock(_intoMutex);
+			_intoMethods.emplace(methodAddr, std::make_unique<IntoMethod>(exportMethod.get(), &method));
+		}
 		_exportMethods.emplace_back(std::move(exportMethod));
 
 		methods.emplace_back(method.name, methodAddr);
@@ -2245,6 +3070,12 @@ LoadResult CSharpLanguageModule::OnPluginLoad(const IPlugin& plugin) {
 }
 
 void CSharpLanguageModule::OnMethodExport(const IPlugin& plugin) {
+	size_t directCount = 0;
+	size_t trampolineCount = 0;
+
+	// Imports are published only when complete, batch lookups from running plugins wait
+	std::unique_lock importLock(_importMutex);
+
 	for (const auto& [name, addr] : plugin.GetMethods()) {
 		auto funcName = std::format("{}.{}::{}", plugin.GetName(), plugin.GetName(), name);
 
@@ -2255,41 +3086,303 @@ void CSharpLanguageModule::OnMethodExport(const IPlugin& plugin) {
 
 		for (const auto& method : plugin.GetDescriptor().exportedMethods) {
 			if (name == method.name) {
-				if (IsMethodPrimitive(method)) {
+				auto [it, result] = _importMethods.try_emplace(funcName, addr, CallThunk(_rt), std::bitset<std::numeric_limits<uint8_t>::max() + 1>{}, &GetMarshalPlan(method), &method);
+				auto& import = std::get<ImportMethod>(*it);
+
+				auto views = _settings.arrayViews.find(funcName);
+				if (views != _settings.arrayViews.end()) {
+					for (uint8_t index : std::get<std::vector<uint8_t>>(*views)) {
+						if (index >= method.paramTypes.size() || method.paramTypes[index].ref || !GetArrayViewElementSize(method.paramTypes[index].type)) {
+							_provider->Log(std::format(LOG_PREFIX "{}: Parameter {} can not be passed as array view", method.funcName, index), Severity::Warning);
+							continue;
+						}
+						import.views.set(index);
+					}
+				}
+
+				if (std::find(_settings.arrayStreams.begin(), _settings.arrayStreams.end(), funcName) != _settings.arrayStreams.end()) {
+					if (ArrayStream::IsSupported(method.retType.type)) {
+						import.stream = true;
+					} else {
+						_provider->Log(std::format(LOG_PREFIX "{}: Return can not be streamed", method.funcName), Severity::Warning);
+					}
+				}
+
+				auto jagged = _settings.jaggedReturns.find(funcName);
+				if (jagged != _settings.jaggedReturns.end()) {
+					MonoClass* rowClass = JaggedArray::FindRowClass(std::get<std::string>(*jagged));
+					if (method.retType.type == ValueType::ArrayUInt8 && !method.retType.ref && rowClass) {
+						import.jaggedRow = rowClass;
+					} else {
+						_provider->Log(std::format(LOG_PREFIX "{}: Return can not be unpacked as '{}'", method.funcName, std::get<std::string>(*jagged)), Severity::Warning);
+					}
+				}
+
+				BindConverters(import);
+
+				// Direct methods are bound as is, but batch calls still go through the thunk
+				if (CallThunk::IsSupported(method) && !import.thunk.GetJitFunc(method, addr)) {
+					_provider->Log(std::format(LOG_PREFIX "{}: Thunk generation error, fallback to dyncall: {}", method.funcName, import.thunk.GetError()), Severity::Warning);
+				}
+
+				if (IsMethodDirect(method)) {
 					mono_add_internal_call(funcName.c_str(), addr);
+					++directCount;
 				} else {
 					Function function(_rt);
-					void* methodAddr = function.GetJitFunc(method, &ExternalCall, addr, [](ValueType type) { return type >= ValueType::HiddenParam; });
+					void* methodAddr = function.GetJitFunc(method, &ExternalCall, &import, [](ValueType type) { return type >= ValueType::HiddenParam; });
 					if (!methodAddr) {
 						_provider->Log(std::format(LOG_PREFIX "{}: {}", method.funcName, function.GetError()), Severity::Error);
+						_importMethods.erase(it);
 						continue;
 					}
-					_functions.emplace(methodAddr, std::move(function));
+					{
+						std::unique_lock lock(_functionMutex);
+						_functions.emplace(methodAddr, std::move(function));
+					}
 
 					mono_add_internal_call(funcName.c_str(), methodAddr);
+					++trampolineCount;
 				}
-
-				_importMethods.emplace(std::move(funcName)/*, ImportMethod{method, addr}*/);
 				break;
 			}
 		}
 	}
+
+	_provider->Log(std::format(LOG_PREFIX "{}: {} methods bound directly, {} through trampoline", plugin.GetName(), directCount, trampolineCount), Severity::Debug);
 }
 
 void CSharpLanguageModule::OnPluginStart(const IPlugin& plugin) {
 	ScriptInstance* script = FindScript(plugin.GetName());
 	if (script) {
 		script->InvokeOnStart();
+		_startedScripts.push_back(script);
+		_updateDirty = true;
 	}
 }
 
 void CSharpLanguageModule::OnPluginEnd(const IPlugin& plugin) {
 	ScriptInstance* script = FindScript(plugin.GetName());
 	if (script) {
+		std::erase(_startedScripts, script);
+		_updateDirty = true;
 		script->InvokeOnEnd();
 	}
 }
 
+void CSharpLanguageModule::OnUpdate(float deltaTime) {
+	if (!_update)
+		return;
+
+	ThreadAttachment::Ensure();
+
+	if (_updateDirty) {
+		RebuildUpdateTargets();
+		_updateDirty = false;
+	}
+
+	// Nothing to tick, do not enter managed code at all
+	if (!_updateCount)
+		return;
+
+	MonoException* exception = nullptr;
+	_update(deltaTime, &exception);
+	if (exception) {
+		HandleException(reinterpret_cast<MonoObject*>(exception), nullptr);
+	}
+}
+
+bool CSharpLanguageModule::IsBatchSupported(const Method& method) {
+	if (method.retType.ref || (method.retType.type != ValueType::Void && !MarshalPlan::GetValueSize(method.retType.type)))
+		return false;
+	return std::all_of(method.paramTypes.begin(), method.paramTypes.end(), [](const Property& param) {
+		return !param.ref && MarshalPlan::GetValueSize(param.type);
+	});
+}
+
+void* CSharpLanguageModule::GetBatchFunction(void* function) {
+	ThreadAttachment::Ensure();
+
+	std::lock_guard lock(_batchMutex);
+
+	auto it = _batchMethods.find(function);
+	if (it == _batchMethods.end())
+		return nullptr;
+
+	auto& batch = *std::get<std::unique_ptr<BatchMethod>>(*it);
+	if (batch.addr)
+		return batch.addr;
+
+	const Method& method = *batch.method;
+	if (!IsBatchSupported(method)) {
+		_provider->Log(std::format(LOG_PREFIX "Method '{}' has no batch form, only primitive parameters and return are supported", method.funcName), Severity::Warning);
+		return nullptr;
+	}
+
+	// Native element size of every column, then of the result column
+	auto getColumnSize = [](ValueType type) {
+		return type == ValueType::Char8 ? uint8_t{1} : MarshalPlan::GetValueSize(type);
+	};
+	std::vector<uint8_t> sizes;
+	sizes.reserve(method.paramTypes.size() + 1);
+	for (const auto& param : method.paramTypes) {
+		sizes.push_back(getColumnSize(param.type));
+	}
+	sizes.push_back(getColumnSize(method.retType.type));
+
+	auto signature = std::make_unique<Method>();
+	signature->name = std::format("{}Batch", method.name);
+	signature->funcName = std::format("{}Batch", method.funcName);
+	signature->callConv = method.callConv;
+	signature->paramTypes.push_back({ ValueType::Pointer, "columns", false, nullptr });
+	signature->paramTypes.push_back({ ValueType::Pointer, "results", false, nullptr });
+	signature->paramTypes.push_back({ ValueType::Int32, "count", false, nullptr });
+	signature->retType = { ValueType::Void, "", false, nullptr };
+	signature->varIndex = method.varIndex;
+
+	// Trampoline is generated first, so a failure does not leave managed invoker registered
+	Function batchFunction(_rt);
+	void* methodAddr = batchFunction.GetJitFunc(*signature, &BatchCall, &batch);
+	if (!methodAddr) {
+		_provider->Log(std::format(LOG_PREFIX "Method '{}' batch JIT generation error: {}", method.funcName, batchFunction.GetError()), Severity::Error);
+		return nullptr;
+	}
+
+	std::array<void*, 2> args{
+		mono_method_get_object(_appDomain.get(), batch.target->method, nullptr),
+		CreateArrayT<uint8_t>(sizes, mono_get_byte_class())
+	};
+	MonoObject* exception = nullptr;
+	MonoObject* result = mono_runtime_invoke(_createBatch, nullptr, args.data(), &exception);
+	if (exception) {
+		HandleException(exception, nullptr);
+		return nullptr;
+	}
+	batch.id = *reinterpret_cast<int32_t*>(mono_object_unbox(result));
+
+	// Owned by the record, shared function maps are not touched outside of plugin loading
+	batch.function.emplace(std::move(batchFunction));
+	batch.signature = std::move(signature);
+
+	batch.addr = methodAddr;
+	return methodAddr;
+}
+
+bool CSharpLanguageModule::IsIntoSupported(const Method& method, bool buffer) {
+	const auto& retType = method.retType;
+	if (retType.ref || retType.type < ValueType::FirstObject || retType.type > ValueType::LastObject)
+		return false;
+	// Array of strings has no flat native form
+	return !buffer || retType.type != ValueType::ArrayString;
+}
+
+std::unique_ptr<Method> CloneMethod(const Method& source);
+
+// Prototype is owned by its property, so delegate parameters need a deep copy
+Property CloneProperty(const Property& source) {
+	return { source.type, source.name, source.ref, source.prototype ? CloneMethod(*source.prototype) : nullptr };
+}
+
+std::unique_ptr<Method> CloneMethod(const Method& source) {
+	auto method = std::make_unique<Method>();
+	method->name = source.name;
+	method->funcName = source.funcName;
+	method->callConv = source.callConv;
+	method->paramTypes.reserve(source.paramTypes.size());
+	for (const auto& param : source.paramTypes) {
+		method->paramTypes.push_back(CloneProperty(param));
+	}
+	method->retType = CloneProperty(source.retType);
+	method->varIndex = source.varIndex;
+	return method;
+}
+
+void* CSharpLanguageModule::GetIntoFunction(void* function, bool buffer) {
+	ThreadAttachment::Ensure();
+
+	std::lock_guard lock(_intoMutex);
+
+	auto it = _intoMethods.find(function);
+	if (it == _intoMethods.end())
+		return nullptr;
+
+	auto& into = *std::get<std::unique_ptr<IntoMethod>>(*it);
+	void*& addr = buffer ? into.bufferAddr : into.addr;
+	if (addr)
+		return addr;
+
+	const Method& method = *into.method;
+	if (!IsIntoSupported(method, buffer)) {
+		_provider->Log(std::format(LOG_PREFIX "Method '{}' has no {} form, only string and array returns are supported", method.funcName, buffer ? "buffer" : "into"), Severity::Warning);
+		return nullptr;
+	}
+
+	Function intoFunction(_rt);
+	void* methodAddr;
+	if (buffer) {
+		// Output buffer replaces hidden return, so parameter positions stay the same
+		auto signature = std::make_unique<Method>();
+		signature->name = std::format("{}IntoBuffer", method.name);
+		signature->funcName = std::format("{}IntoBuffer", method.funcName);
+		signature->callConv = method.callConv;
+		signature->paramTypes.push_back({ ValueType::Pointer, "out", false, nullptr });
+		for (const auto& param : method.paramTypes) {
+			signature->paramTypes.push_back(CloneProperty(param));
+		}
+		signature->retType = { ValueType::Pointer, "", false, nullptr };
+		signature->varIndex = method.varIndex;
+
+		methodAddr = intoFunction.GetJitFunc(*signature, &InternalCallIntoBuffer, &into);
+		into.bufferSignature = std::move(signature);
+	} else {
+		methodAddr = intoFunction.GetJitFunc(method, &InternalCallInto, &into);
+	}
+	if (!methodAddr) {
+		_provider->Log(std::format(LOG_PREFIX "Method '{}' into JIT generation error: {}", method.funcName, intoFunction.GetError()), Severity::Error);
+		return nullptr;
+	}
+	// Owned by the record, shared function maps are not touched outside of plugin loading
+	(buffer ? into.bufferFunction : into.function).emplace(std::move(intoFunction));
+
+	addr = methodAddr;
+	return methodAddr;
+}
+
+void CSharpLanguageModule::RebuildUpdateTargets() {
+	const auto& order = _settings.updateOrder;
+	auto getRank = [&order](const ScriptInstance* script) {
+		return static_cast<size_t>(std::distance(order.begin(), std::find(order.begin(), order.end(), script->GetPlugin().GetName())));
+	};
+
+	std::vector<const ScriptInstance*> targets;
+	targets.reserve(_startedScripts.size());
+	for (const ScriptInstance* script : _startedScripts) {
+		if (_settings.updateAll || getRank(script) != order.size())
+			targets.push_back(script);
+	}
+
+	// Listed plugins first in configured order, then the rest in start order
+	std::stable_sort(targets.begin(), targets.end(), [&getRank](const ScriptInstance* lhs, const ScriptInstance* rhs) {
+		return getRank(lhs) < getRank(rhs);
+	});
+
+	MonoArray* array = CreateArray(_plugin.klass, targets.size());
+	for (size_t i = 0; i < targets.size(); ++i) {
+		mono_array_setref(array, i, targets[i]->GetManagedObject());
+	}
+
+	std::array<void*, 1> args{ array };
+	MonoObject* exception = nullptr;
+	MonoObject* result = mono_runtime_invoke(_setUpdateTargets, nullptr, args.data(), &exception);
+	if (exception) {
+		HandleException(exception, nullptr);
+		_updateCount = 0;
+		return;
+	}
+
+	_updateCount = static_cast<size_t>(*reinterpret_cast<int32_t*>(mono_object_unbox(result)));
+}
+
 ScriptInstance* CSharpLanguageModule::CreateScriptInstance(const IPlugin& plugin, MonoImage* image) {
 	const MonoTableInfo* typeDefinitionsTable = mono_image_get_table_info(image, MONO_TABLE_TYPEDEF);
 	int numTypes = mono_table_info_get_rows(typeDefinitionsTable);
@@ -2338,32 +3431,88 @@ MonoDelegate* CSharpLanguageModule::CreateDelegate(void* func, const plugify::Me
 	if (IsMethodPrimitive(method)) {
 		return mono_ftnptr_to_delegate(delegateClass, func);
 	} else {
+		// Delegates are short-lived, so they use dyncall instead of generating a thunk each time
+		auto* import = new ImportMethod{ func, CallThunk(_rt), {}, &GetMarshalPlan(method), &method };
+		BindConverters(*import);
 		auto* function = new plugify::Function(_rt);
-		void* methodAddr = function->GetJitFunc(method, &ExternalCall, func);
+		void* methodAddr = function->GetJitFunc(method, &ExternalCall, import);
 		MonoDelegate* delegate = mono_ftnptr_to_delegate(delegateClass, methodAddr);
 		mono_gc_reference_queue_add(_functionReferenceQueue.get(), reinterpret_cast<MonoObject*>(delegate), reinterpret_cast<void*>(function));
+		mono_gc_reference_queue_add(_importReferenceQueue.get(), reinterpret_cast<MonoObject*>(delegate), reinterpret_cast<void*>(import));
 		return delegate;
 	}
 }
 
 template<typename T>
 MonoString* CSharpLanguageModule::CreateString(const T& source) const {
-	return source.empty() ? mono_string_empty(_appDomain.get()) : mono_string_new(_appDomain.get(), source.data());
+	if (source.empty())
+		return mono_string_empty(_appDomain.get());
+	// Allocate managed string of the exact size and transcode straight into its storage
+	size_t length = Utf8::GetUtf16Length(source.data(), source.size());
+	MonoString* string = mono_string_new_size(_appDomain.get(), static_cast<int32_t>(length));
+	Utf8::ToUtf16(source.data(), source.size(), reinterpret_cast<char16_t*>(mono_string_chars(string)));
+	return string;
+}
+
+// Short strings are shared through the cache (if enabled), managed strings are immutable
+MonoString* CSharpLanguageModule::CreateInternedString(std::string_view source) const {
+	if (!_stringCache || source.empty() || source.size() > _settings.stringCacheMaxLength)
+		return CreateString(source);
+	MonoString* string = _stringCache->Find(source);
+	if (!string) {
+		string = CreateString(source);
+		_stringCache->Insert(source, string);
+	}
+	return string;
 }
 
 template<typename T>
 MonoArray* CSharpLanguageModule::CreateArrayT(const std::vector<T>& source, MonoClass* klass) {
-	MonoArray* array = CreateArray(klass, source.size());
-	for (size_t i = 0; i < source.size(); ++i) {
-		if constexpr (std::is_same_v<T, char>) {
-			mono_array_set(array, char16_t, i, static_cast<char16_t>(source[i]));
-		} else {
-			mono_array_set(array, T, i, source[i]);
+	if constexpr (std::is_same_v<T, uint8_t>) {
+		// Rows are arrays, so source is packed jagged array
+		if (mono_class_get_rank(klass) == 1)
+			return JaggedArray::Unpack(source, klass);
+	}
+	if constexpr (std::is_same_v<T, float>) {
+		// Vector and matrix arrays are filled from flat floats
+		auto elementSize = static_cast<size_t>(mono_class_array_element_size(klass));
+		if (elementSize != sizeof(float)) {
+			size_t bytes = source.size() * sizeof(float);
+			if (bytes % elementSize != 0) {
+				_provider->Log(std::format(LOG_PREFIX "Float array of {} elements can not fill '{}' array, it is not a multiple of {} floats", source.size(), mono_class_get_name(klass), elementSize / sizeof(float)), Severity::Error);
+				return nullptr;
+			}
+			size_t count = bytes / elementSize;
+			MonoArray* array = CreateArray(klass, count);
+			if (count)
+				std::memcpy(mono_array_addr_with_size(array, static_cast<int>(elementSize), 0), source.data(), count * elementSize);
+			return array;
 		}
 	}
+	MonoArray* array = CreateArray(klass, source.size());
+	VectorToMonoArray(source, array);
 	return array;
 }
 
+// Reuses managed array if length is unchanged, its contents are written only if they differ
+template<typename T>
+MonoArray* CSharpLanguageModule::UpdateArrayT(MonoArray* original, const std::vector<T>& source, MonoClass* klass) {
+	if constexpr (std::is_same_v<T, float>) {
+		// Keep element type of the array managed side gave us
+		if (original != nullptr)
+			klass = mono_class_get_element_class(mono_object_get_class(reinterpret_cast<MonoObject*>(original)));
+	}
+	if constexpr (std::is_same_v<T, uint8_t>) {
+		if (original != nullptr && JaggedArray::IsJagged(original))
+			return JaggedArray::Unpack(source, mono_class_get_element_class(mono_object_get_class(reinterpret_cast<MonoObject*>(original))));
+	}
+	if (original == nullptr || GetArrayLength<T>(original) != source.size())
+		return CreateArrayT(source, klass);
+	if (!MonoArrayEquals(original, source))
+		VectorToMonoArray(source, original);
+	return original;
+}
+
 MonoArray* CSharpLanguageModule::CreateArray(MonoClass* klass, size_t count) const {
 	return mono_array_new(_appDomain.get(), klass, count);
 }
@@ -2372,11 +3521,60 @@ template<typename T>
 MonoArray* CSharpLanguageModule::CreateStringArray(const std::vector<T>& source) const {
 	MonoArray* array = CreateArray(mono_get_string_class(), source.size());
 	for (size_t i = 0; i < source.size(); ++i) {
-		mono_array_set(array, MonoString*, i, CreateString(source[i]));
+		mono_array_setref(array, i, CreateInternedString(source[i]));
 	}
 	return array;
 }
 
+// Strings are packed into one UTF-8 blob and decoded on managed side only when accessed
+MonoObject* CSharpLanguageModule::CreateStringList(const std::vector<std::string>& source) const {
+	size_t bytes = 0;
+	for (const auto& element : source) {
+		bytes += element.size();
+	}
+
+	MonoArray* data = CreateArray(mono_get_byte_class(), bytes);
+	MonoArray* offsets = CreateArray(mono_get_int32_class(), source.size() + 1);
+	auto* dest = mono_array_addr(data, char, 0);
+	auto* offset = mono_array_addr(offsets, int32_t, 0);
+	size_t position = 0;
+	for (const auto& element : source) {
+		*offset++ = static_cast<int32_t>(position);
+		std::memcpy(dest + position, element.data(), element.size());
+		position += element.size();
+	}
+	*offset = static_cast<int32_t>(position);
+
+	MonoObject* list = mono_object_new(_appDomain.get(), _stringList);
+	mono_field_set_value(list, _stringListData, data);
+	mono_field_set_value(list, _stringListOffsets, offsets);
+	return list;
+}
+
+// Stream is owned by managed object and released by its Dispose or finalizer
+MonoObject* CSharpLanguageModule::CreateArrayStream(ValueType type, void* container, MonoClass* elementClass) const {
+	ArrayStream* stream = ArrayStream::Create(type, container, elementClass);
+	MonoObject* object = mono_object_new(_appDomain.get(), _arrayStream);
+	mono_field_set_value(object, _arrayStreamHandle, &stream);
+	return object;
+}
+
+MonoArray* CSharpLanguageModule::UpdateStringArray(MonoArray* original, const std::vector<std::string>& source) const {
+	if (original == nullptr || mono_array_length(original) != source.size())
+		return CreateStringArray(source);
+	for (size_t i = 0; i < source.size(); ++i) {
+		if (!MonoStringEquals(mono_array_get(original, MonoString*, i), source[i]))
+			mono_array_setref(original, i, CreateString(source[i]));
+	}
+	return original;
+}
+
+MonoString* CSharpLanguageModule::UpdateString(MonoString* original, const std::string& source) const {
+	if (original != nullptr && MonoStringEquals(original, source))
+		return original;
+	return CreateString(source);
+}
+
 MonoObject* CSharpLanguageModule::InstantiateClass(MonoClass* klass) const {
 	MonoObject* instance = mono_object_new(_appDomain.get(), klass);
 	mono_runtime_object_init(instance);
@@ -2526,3 +3724,19 @@ namespace monolm {
 plugify::ILanguageModule* GetLanguageModule() {
 	return &monolm::g_monolm;
 }
+
+void UpdateLanguageModule(float deltaTime) {
+	monolm::g_monolm.OnUpdate(deltaTime);
+}
+
+void* GetMethodBatch(void* function) {
+	return monolm::g_monolm.GetBatchFunction(function);
+}
+
+void* GetMethodInto(void* function) {
+	return monolm::g_monolm.GetIntoFunction(function, false);
+}
+
+void* GetMethodIntoBuffer(void* function) {
+	return monolm::g_monolm.GetIntoFunction(function, true);
+}
@@ -1,5 +1,12 @@
 #pragma once
 
+#include "aggregate.h"
+#include "arena.h"
+#include "context.h"
+#include "intern.h"
+#include "plan.h"
+#include "thunk.h"
+
 #include <asmjit/asmjit.h>
 #include <dyncall/dyncall.h>
 #include <module_export.h>
@@ -18,6 +25,9 @@ extern "C" {
 	typedef struct _MonoArray MonoArray;
 	typedef struct _MonoDelegate MonoDelegate;
 	typedef struct _MonoString MonoString;
+	typedef struct _MonoException MonoException;
+	typedef struct _MonoType MonoType;
+	typedef struct _MonoReflectionType MonoReflectionType;
 	typedef struct _MonoDomain MonoDomain;
 	typedef int32_t mono_bool;
 }
@@ -54,20 +64,92 @@ namespace monolm {
 	};
 
 	std::string MonoStringToUTF8(MonoString* string);
+	void MonoStringToUTF8(MonoString* string, std::string& dest);
+	/// Compares managed string with UTF-8 one without transcoding, null equals empty.
+	bool MonoStringEquals(MonoString* string, std::string_view source);
 	template<typename T>
 	void MonoArrayToVector(MonoArray* array, std::vector<T>& dest);
+	template<typename T>
+	void VectorToMonoArray(const std::vector<T>& source, MonoArray* array);
+	template<typename T>
+	bool MonoArrayEquals(MonoArray* array, const std::vector<T>& source);
 
 	using ScriptMap = std::unordered_map<std::string, ScriptInstance>;
-	using ArgumentList = std::vector<void*>;
+	using ArgumentList = InlineVector<void*, 16>;
+
+	/// Pointer+length view of a pinned managed array, passed instead of std::vector<T>*
+	/// for parameters listed in the "arrayViews" setting. Valid only for the duration of the call.
+	template<typename T>
+	struct ArrayView {
+		const T* data;
+		size_t size;
+	};
+
+	struct ImportMethod;
+	class ArrayStream;
+
+	/// Conversion of one managed argument into its native slot, chosen once per import by type, ref and view.
+	using ArgConverter = void(*)(const plugify::Property& param, const plugify::Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args);
+	/// Conversion of native return into managed one, args[0] is the hidden return storage.
+	using ReturnConverter = void(*)(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
+	using ReturnAllocator = void*(*)(Arena& arena, ArgumentList& args);
 
-	/*struct ImportMethod {
-		MethodRef method;
+	struct ImportMethod {
 		void* addr{ nullptr };
-	};*/
+		CallThunk thunk;
+		std::bitset<std::numeric_limits<uint8_t>::max() + 1> views;
+		const MarshalPlan* plan{ nullptr };
+		const plugify::Method* method{ nullptr };
+		bool stream{ false }; // array return is handed out as NativeArrayStream
+		MonoClass* jaggedRow{ nullptr }; // row class when uint8* return is unpacked into jagged array
+		std::vector<ArgConverter> converters{}; // filled by BindConverters after views and stream are known
+		ReturnConverter storeReturn{ nullptr }; // nullptr when there is nothing to store (void or aggregate stored by dyncall)
+		ReturnAllocator allocateReturn{ nullptr }; // storage for string or array return
+	};
 
 	struct ExportMethod {
 		MonoMethod* method{ nullptr };
 		MonoObject* instance{ nullptr };
+		const MarshalPlan* plan{ nullptr };
+		CallThunk thunk; // calls mono unmanaged thunk directly, not generated when signature is unsupported
+	};
+
+	/// Compiled Invoke of one delegate class for one signature, shared by all delegates of that class.
+	struct DelegateInvoker {
+		CallThunk thunk;
+		const MarshalPlan* plan{ nullptr };
+	};
+
+	/// Batch entry point of an exported method: void(const void* const* columns, void* results, int32_t count).
+	/// Column i holds count native values of parameter i, generated on first request.
+	struct BatchMethod {
+		ExportMethod* target{ nullptr };
+		const plugify::Method* method{ nullptr };
+		int32_t id{ -1 };
+		void* addr{ nullptr };
+		std::optional<plugify::Function> function;
+		std::unique_ptr<plugify::Method> signature;
+	};
+
+	/// Output forms of an exported method which returns string or array, generated on first request.
+	/// Container form has the same signature, but the hidden return points to container constructed by caller
+	/// which is assigned in place. Buffer form is OutputBuffer*(OutputBuffer* out, params...).
+	struct IntoMethod {
+		ExportMethod* target{ nullptr };
+		const plugify::Method* method{ nullptr };
+		void* addr{ nullptr };
+		void* bufferAddr{ nullptr };
+		std::optional<plugify::Function> function;
+		std::optional<plugify::Function> bufferFunction;
+		std::unique_ptr<plugify::Method> bufferSignature;
+	};
+
+	/// Capacity bounded destination of buffer form, string is written as UTF-8 bytes, arrays as native elements.
+	/// size receives full length of the result, elements past capacity are dropped.
+	struct OutputBuffer {
+		void* data;
+		size_t capacity;
+		size_t size;
 	};
 
 	struct AssemblyInfo {
@@ -93,19 +175,34 @@ namespace monolm {
 		void OnPluginEnd(const plugify::IPlugin& plugin) override;
 		void OnMethodExport(const plugify::IPlugin& plugin) override;
 
+		/// Ticks every started plugin which has OnUpdate(float) with a single managed transition.
+		void OnUpdate(float deltaTime);
+		/// Returns batch form of exported method by its address, nullptr if signature is not primitive-only.
+		void* GetBatchFunction(void* function);
+		/// Returns form of exported method which writes string or array return into caller storage, nullptr if not applicable.
+		void* GetIntoFunction(void* function, bool buffer);
+
 		const ScriptMap& GetScripts() const { return _scripts; }
 		ScriptInstance* FindScript(const std::string& name);
 
 		const std::shared_ptr<plugify::IPlugifyProvider>& GetProvider() { return _provider; }
+		const AggregateRegistry& GetAggregates() const { return *_aggregates; }
 
 		template<typename T>
 		MonoArray* CreateArrayT(const std::vector<T>& source, MonoClass* klass);
 		MonoDelegate* CreateDelegate(void* func, const plugify::Method& method);
 		template<typename T>
 		MonoString* CreateString(const T& source) const;
+		MonoString* CreateInternedString(std::string_view source) const;
 		MonoArray* CreateArray(MonoClass* klass, size_t count) const;
 		template<typename T>
 		MonoArray* CreateStringArray(const std::vector<T>& source) const;
+		template<typename T>
+		MonoArray* UpdateArrayT(MonoArray* original, const std::vector<T>& source, MonoClass* klass);
+		MonoObject* CreateStringList(const std::vector<std::string>& source) const;
+		MonoObject* CreateArrayStream(plugify::ValueType type, void* container, MonoClass* elementClass) const;
+		MonoArray* UpdateStringArray(MonoArray* original, const std::vector<std::string>& source) const;
+		MonoString* UpdateString(MonoString* original, const std::string& source) const;
 		MonoObject* InstantiateClass(MonoClass* klass) const;
 
 	private:
@@ -120,62 +217,184 @@ namespace monolm {
 		static void OnPrintCallback(const char* message, mono_bool isStdout);
 		static void OnPrintErrorCallback(const char* message, mono_bool isStdout);
 
-		static void ExternalCall(const plugify::Method* method, void* addr, const plugify::Parameters* params, uint8_t count, const plugify::ReturnValue* ret);
+		static void ExternalCall(const plugify::Method* method, void* data, const plugify::Parameters* params, uint8_t count, const plugify::ReturnValue* ret);
 		static void InternalCall(const plugify::Method* method, void* data, const plugify::Parameters* params, uint8_t count, const plugify::ReturnValue* ret);
 		static void DelegateCall(const plugify::Method* method, void* data, const plugify::Parameters* params, uint8_t count, const plugify::ReturnValue* ret);
-
-		static void DeleteParam(const std::vector<void*>& args, uint8_t& i, plugify::ValueType type);
-		static void DeleteReturn(const std::vector<void*>& args, uint8_t& i, plugify::ValueType type);
-		static void SetReturn(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
-		static void SetParams(const plugify::Method* method, const plugify::Parameters* p, uint8_t count, bool hasRet, bool& hasRefs, ArgumentList& args);
-		static void SetReferences(const plugify::Method* method, const plugify::Parameters* p, uint8_t count, bool hasRet, bool hasRefs, const ArgumentList& args);
-		static void PullReferences(const plugify::Method* method, const plugify::Parameters* p, uint8_t count, bool hasRet, bool hasRefs, const ArgumentList& args);
+		static void BatchCall(const plugify::Method* method, void* data, const plugify::Parameters* params, uint8_t count, const plugify::ReturnValue* ret);
+		static bool IsBatchSupported(const plugify::Method& method);
+		static MonoArray* InvokeBatch(MonoString* name, MonoArray* columns);
+		static ArrayStream* OpenArrayStream(MonoString* name, MonoReflectionType* elementType);
+		static MonoClass* GetColumnClass(plugify::ValueType type);
+		static void InternalCallInto(const plugify::Method* method, void* data, const plugify::Parameters* params, uint8_t count, const plugify::ReturnValue* ret);
+		static void InternalCallIntoBuffer(const plugify::Method* method, void* data, const plugify::Parameters* params, uint8_t count, const plugify::ReturnValue* ret);
+		static bool IsIntoSupported(const plugify::Method& method, bool buffer);
+		static bool CallInto(const IntoMethod& into, const plugify::Parameters* p, MonoObject*& result);
+		static void AssignReturn(const plugify::Method& method, const plugify::Parameters* p, MonoObject* result);
+		static void WriteReturnBuffer(const plugify::Method& method, OutputBuffer& buffer, MonoObject* result);
+
+		static bool CallVirtMachine(const plugify::Method* method, void* addr, const plugify::Parameters* p, const plugify::ReturnValue* ret, const NativeSlot* slots, uint8_t count, bool hasRet, NativeSlot& result);
+		static void SetReturn(const MarshalPlan& plan, const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+		static void SetReturnSlot(const MarshalPlan& plan, const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, const NativeSlot& result);
+		static void SetParams(const MarshalPlan& plan, const plugify::Parameters* p, Arena& arena, ArgumentList& args);
+		static void SetReferences(const MarshalPlan& plan, const plugify::Parameters* p, const ArgumentList& args);
+		static void PullReferences(const MarshalPlan& plan, const plugify::Parameters* p, const ArgumentList& args);
+		static void BindConverters(ImportMethod& import);
+		static void BindConverters(MarshalPlan& plan, const plugify::Method& method);
+
+		static void* ArgumentValue(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		static void* ArgumentPointer(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		template<bool Ref>
+		static void* CharToArg(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		static void* DelegateToArg(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		template<bool Ref>
+		static void* StringToArg(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		template<typename T, bool Ref>
+		static void* ArrayToArg(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		static void* UnsupportedArg(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		static void CharFromRef(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, void* arg);
+		static void StringFromRef(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, void* arg);
+		template<typename T>
+		static void ArrayFromRef(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, void* arg);
+		template<typename T, typename N = T>
+		static void ResultValue(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+		template<typename T>
+		static void ResultHidden(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+		static void ResultDelegate(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+		static void ResultString(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+		template<typename T>
+		static void ResultArray(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+		static void UnsupportedResult(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+		template<typename N, typename T = N>
+		static void ResultSlotValue(const plugify::ReturnValue* ret, uint64_t result);
+
+		template<typename T, typename N = T>
+		static void ValueToSlot(const plugify::Property& param, const plugify::Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args);
+		template<bool Ref>
+		static void DelegateToSlot(const plugify::Property& param, const plugify::Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args);
+		template<bool Ref>
+		static void StringToSlot(const plugify::Property& param, const plugify::Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args);
+		template<typename T, bool Ref>
+		static void ArrayToSlot(const plugify::Property& param, const plugify::Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args);
+		template<size_t Size>
+		static void ViewToSlot(const plugify::Property& param, const plugify::Parameters* p, uint8_t i, NativeSlot& slot, Arena& arena, ArgumentList& args);
+		template<typename N, typename T = N>
+		static void ReturnValueSlot(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
+		static void ReturnDelegate(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
+		static void ReturnString(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
+		template<typename T>
+		static void ReturnArray(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
+		static void ReturnStringArray(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
+		static void ReturnStream(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
+		static void ReturnJagged(const ImportMethod& import, const plugify::ReturnValue* ret, const NativeSlot& result, const ArgumentList& args);
 
 		template<typename T>
-		static void* MonoStructToArg(ArgumentList& args);
+		static void* MonoStructToArg(Arena& arena, ArgumentList& args);
 		template<typename T>
-		static void* MonoArrayToArg(MonoArray* source, ArgumentList& args);
-		static void* MonoStringToArg(MonoString* source, ArgumentList& args);
+		static void* MonoArrayToArg(MonoArray* source, Arena& arena, ArgumentList& args);
+		static void* MonoStringToArg(MonoString* source, Arena& arena, ArgumentList& args);
+		static void* MonoArrayToView(MonoArray* source, size_t elementSize, Arena& arena, ArgumentList& args);
+		static size_t GetArrayViewElementSize(plugify::ValueType type);
+		static void* NativeStructToArg(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		static void* NativeViewToArg(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+		plugify::ValueType GetViewParamType(MonoType* type, const plugify::Property& param, MarshalOp& op, std::string& error);
+		plugify::ValueType GetStructParamType(MonoType* type, const plugify::Property& param, MarshalOp& op, std::string& error);
+		uint32_t VerifyStruct(MonoClass* klass, std::string& error);
 		void* MonoDelegateToArg(MonoDelegate* source, const plugify::Method& method);
 
+		static std::optional<asmjit::TypeId> GetManagedTypeId(const plugify::Property& property);
+		static bool CreateManagedThunk(CallThunk& thunk, MonoMethod* monoMethod, bool instance, const plugify::Method& method);
+		static MonoObject* CallManagedThunk(CallThunk::ThunkFunc func, MonoObject* instance, const MarshalPlan& plan, const ArgumentList& args, NativeSlot& result);
+		const DelegateInvoker& GetDelegateInvoker(MonoObject* delegate, const plugify::Method& method);
+
 		void CleanupDelegateCache();
+		void RebuildUpdateTargets();
+		const MarshalPlan& GetMarshalPlan(const plugify::Method& method);
 
 	private:
 		std::deleted_unique_ptr<MonoDomain> _rootDomain;
 		std::deleted_unique_ptr<MonoDomain> _appDomain;
 		std::deleted_unique_ptr<MonoReferenceQueue> _functionReferenceQueue;
+		std::deleted_unique_ptr<MonoReferenceQueue> _importReferenceQueue;
 		std::deleted_unique_ptr<MonoAssemblyName> _assemblyName;
 
 		AssemblyInfo _core;
 		ClassInfo _plugin;
+		MonoMethod* _setUpdateTargets{ nullptr };
+		MonoMethod* _createBatch{ nullptr };
+		MonoClass* _stringList{ nullptr };
+		MonoClassField* _stringListData{ nullptr };
+		MonoClassField* _stringListOffsets{ nullptr };
+		MonoClass* _arrayStream{ nullptr };
+		MonoClassField* _arrayStreamHandle{ nullptr };
 		//ClassInfo _vector2;
 		//ClassInfo _vector3;
 		//ClassInfo _vector4;
 		//ClassInfo _matrix4x4;
 
 		std::shared_ptr<asmjit::JitRuntime> _rt;
+		std::unique_ptr<AggregateRegistry> _aggregates;
+		std::unique_ptr<StringCache> _stringCache;
 		std::shared_ptr<plugify::IPlugifyProvider> _provider;
 		
-		std::set<std::string/*, ImportMethod*/> _importMethods;
+		std::map<std::string, ImportMethod> _importMethods;
+		std::shared_mutex _importMutex; // map only, entries keep their address until shutdown
 		std::vector<std::unique_ptr<ExportMethod>> _exportMethods;
 		
 		std::vector<std::unique_ptr<plugify::Method>> _methods;
 		std::unordered_map<void*, plugify::Function> _functions;
+		std::shared_mutex _functionMutex;
 
-		std::deleted_unique_ptr<DCCallVM> _callVirtMachine;
 		std::map<uint32_t, void*> _cachedDelegates;
-		std::mutex _mutex;
+
+		using UpdateThunk = void(*)(float deltaTime, MonoException** exception);
+		UpdateThunk _update{ nullptr };
+		std::vector<const ScriptInstance*> _startedScripts;
+		size_t _updateCount{ 0 };
+		bool _updateDirty{ false };
+
+		using InvokeBatchThunk = void(*)(int32_t id, MonoObject* target, const void* const* columns, void* results, int32_t count, MonoException** exception);
+		InvokeBatchThunk _invokeBatch{ nullptr };
+		std::unordered_map<void*, std::unique_ptr<BatchMethod>> _batchMethods;
+		std::mutex _batchMutex;
+		std::unordered_map<void*, std::unique_ptr<IntoMethod>> _intoMethods;
+		std::mutex _intoMutex;
+		std::unordered_map<const plugify::Method*, std::unique_ptr<MarshalPlan>> _plans;
+		std::map<std::pair<MonoClass*, const plugify::Method*>, std::unique_ptr<DelegateInvoker>> _delegateInvokers;
+		std::vector<std::unique_ptr<MarshalPlan>> _structPlans;
+		std::unordered_map<MonoClass*, uint32_t> _structs;
+		std::shared_mutex _planMutex;
+		std::shared_mutex _invokerMutex;
+		CountedMutex _delegateMutex;
 
 		std::vector<MonoClass*> _funcClasses;
 		std::vector<MonoClass*> _actionClasses;
 
 		ScriptMap _scripts;
 
+		struct StructField {
+			std::string name;
+			size_t offset{ 0 };
+		};
+
+		/// Expected layout of user blittable value type, verified against class metadata on plugin load.
+		struct StructLayout {
+			size_t size{ 0 };
+			std::vector<StructField> fields;
+		};
+
 		struct MonoSettings {
 			bool enableDebugging{ false };
 			std::string level;
 			std::string mask;
 			std::vector<std::string> options;
+			std::unordered_map<std::string, std::vector<uint8_t>> arrayViews;
+			size_t stringCacheSize{ 0 };
+			size_t stringCacheMaxLength{ 128 };
+			std::vector<std::string> updateOrder; // plugins ticked first, in this order
+			bool updateAll{ true }; // if false, only plugins listed in updateOrder are ticked
+			std::unordered_map<std::string, StructLayout> structs; // by full managed type name
+			std::vector<std::string> arrayStreams; // imports whose array return is read by NativeArrayStream
+			std::unordered_map<std::string, std::string> jaggedReturns; // imports whose uint8* return is unpacked, to managed type name
 		} _settings;
 
 		friend class ScriptInstance;
@@ -184,4 +403,8 @@ namespace monolm {
 	extern CSharpLanguageModule g_monolm;
 }
 
-extern "C" MONOLM_EXPORT plugify::ILanguageModule* GetLanguageModule();
\ No newline at end of file
+extern "C" MONOLM_EXPORT plugify::ILanguageModule* GetLanguageModule();
+extern "C" MONOLM_EXPORT void UpdateLanguageModule(float deltaTime);
+extern "C" MONOLM_EXPORT void* GetMethodBatch(void* function);
+extern "C" MONOLM_EXPORT void* GetMethodInto(void* function);
+extern "C" MONOLM_EXPORT void* GetMethodIntoBuffer(void* function);
\ No newline at end of file
@@ -3,16 +3,22 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <list>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <utility>
 #include <functional>
 #include <optional>
 #include <span>
+#include <array>
+#include <bitset>
 #include <mutex>
+#include <shared_mutex>
+#include <atomic>
 #include <fstream>
 
 #include <filesystem>
@@ -0,0 +1,105 @@
+#include "plan.h"
+
+#include <mono/metadata/appdomain.h>
+#include <plugify/method.h>
+
+using namespace monolm;
+using namespace plugify;
+
+MonoClass* MarshalPlan::GetElementClass(ValueType type) {
+	switch (type) {
+		case ValueType::ArrayBool:
+			return mono_get_byte_class();
+		case ValueType::ArrayChar8:
+		case ValueType::ArrayChar16:
+			return mono_get_char_class();
+		case ValueType::ArrayInt8:
+			return mono_get_sbyte_class();
+		case ValueType::ArrayInt16:
+			return mono_get_int16_class();
+		case ValueType::ArrayInt32:
+			return mono_get_int32_class();
+		case ValueType::ArrayInt64:
+			return mono_get_int64_class();
+		case ValueType::ArrayUInt8:
+			return mono_get_byte_class();
+		case ValueType::ArrayUInt16:
+			return mono_get_uint16_class();
+		case ValueType::ArrayUInt32:
+			return mono_get_uint32_class();
+		case ValueType::ArrayUInt64:
+			return mono_get_uint64_class();
+		case ValueType::ArrayPointer:
+			return mono_get_intptr_class();
+		case ValueType::ArrayFloat:
+			return mono_get_single_class();
+		case ValueType::ArrayDouble:
+			return mono_get_double_class();
+		case ValueType::ArrayString:
+			return mono_get_string_class();
+		default:
+			return nullptr;
+	}
+}
+
+uint8_t MarshalPlan::GetValueSize(ValueType type) {
+	switch (type) {
+		case ValueType::Bool:
+		case ValueType::Int8:
+		case ValueType::UInt8:
+			return 1;
+		case ValueType::Char8: // widened to System.Char
+		case ValueType::Char16:
+		case ValueType::Int16:
+		case ValueType::UInt16:
+			return 2;
+		case ValueType::Int32:
+		case ValueType::UInt32:
+		case ValueType::Float:
+			return 4;
+		case ValueType::Int64:
+		case ValueType::UInt64:
+		case ValueType::Double:
+			return 8;
+		case ValueType::Pointer:
+			return static_cast<uint8_t>(sizeof(void*));
+		default:
+			return 0;
+	}
+}
+
+MarshalPlan MarshalPlan::Build(const Method& method) {
+	MarshalPlan plan;
+	plan.retClass = GetElementClass(method.retType.type);
+	plan.hiddenRet = ValueTypeIsHiddenObjectParam(method.retType.type);
+	plan.params.reserve(method.paramTypes.size());
+
+	// Object return storage takes the first temporary of ExternalCall, then every string and array parameter
+	bool objectRet = method.retType.type >= ValueType::FirstObject && method.retType.type <= ValueType::LastObject;
+	auto slot = static_cast<uint8_t>(objectRet);
+
+	for (size_t i = 0; i < method.paramTypes.size(); ++i) {
+		const auto& param = method.paramTypes[i];
+		bool object = param.type >= ValueType::FirstObject && param.type <= ValueType::LastObject;
+
+		MarshalOp op{
+			param.type,
+			param.ref,
+			static_cast<uint8_t>(i),
+			object ? slot++ : uint8_t{},
+			param.ref ? uint8_t{} : GetValueSize(param.type),
+			GetElementClass(param.type),
+			param.prototype.get(),
+			0,
+			ViewKind::None
+		};
+
+		plan.params.push_back(op);
+		if (param.ref) {
+			plan.writeBack.push_back(op);
+		}
+		plan.hasRefs |= param.ref;
+	}
+
+	return plan;
+}
\ No newline at end of file
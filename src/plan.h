@@ -0,0 +1,67 @@
+#pragma once
+
+#include <plugify/value_type.h>
+
+extern "C" {
+	typedef struct _MonoClass MonoClass;
+	typedef struct _MonoObject MonoObject;
+}
+
+namespace plugify {
+	struct Method;
+	struct Parameters;
+	struct ReturnValue;
+}
+
+namespace monolm {
+	/// Managed view which replaces the copy of native string or array parameter.
+	enum class ViewKind : uint8_t {
+		None,
+		Span, // NativeSpan<T> or NativeString over std::vector<T> or std::string
+		Vector, // NativeVector<T> over std::vector<T> or std::string passed by reference
+		StringList, // NativeStringList packed from std::vector<std::string>
+	};
+
+	class Arena;
+	struct MarshalOp;
+
+	/// Conversion of one native argument into the managed call argument.
+	using ParamConverter = void*(*)(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, Arena& arena);
+	/// Copy of managed argument passed by reference back into the native one.
+	using WriteBackConverter = void(*)(const MarshalOp& op, const plugify::Parameters* p, uint8_t i, void* arg);
+	/// Store of boxed or reference managed result into the native return.
+	using ResultConverter = void(*)(const plugify::Method* method, const plugify::Parameters* p, const plugify::ReturnValue* ret, MonoObject* result);
+	/// Store of primitive result returned by the managed thunk in a NativeSlot.
+	using ResultSlotConverter = void(*)(const plugify::ReturnValue* ret, uint64_t result);
+
+	/// Single pre-resolved marshalling step of one parameter.
+	struct MarshalOp {
+		plugify::ValueType type;
+		bool ref;
+		uint8_t index; // position in Method::paramTypes
+		uint8_t slot; // position of the native temporary in ExternalCall argument list
+		uint8_t size; // bytes of managed by-value primitive, 0 when passed as pointer
+		MonoClass* klass; // element class of arrays
+		const plugify::Method* prototype; // signature of delegates
+		uint32_t stride; // size of user blittable struct passed as Pointer or ArrayUInt8, 0 otherwise
+		ViewKind view;
+		ParamConverter convert{ nullptr }; // set by BindConverters once the op is final
+		WriteBackConverter copyBack{ nullptr }; // nullptr when reference needs no copy back
+	};
+
+	/// Compiled form of plugify::Method, built once per signature and executed on every call
+	/// instead of re-walking Method::paramTypes and resolving classes again.
+	struct MarshalPlan {
+		std::vector<MarshalOp> params;
+		std::vector<MarshalOp> writeBack; // reference parameters which need work after the call
+		MonoClass* retClass{ nullptr };
+		bool hiddenRet{ false }; // return passed through the first native parameter
+		bool hasRefs{ false };
+		ResultConverter storeResult{ nullptr }; // nullptr for void
+		ResultSlotConverter storeResultSlot{ nullptr }; // nullptr when thunk result is a managed reference
+
+		static MarshalPlan Build(const plugify::Method& method);
+		static MonoClass* GetElementClass(plugify::ValueType type);
+		static uint8_t GetValueSize(plugify::ValueType type);
+	};
+}
\ No newline at end of file
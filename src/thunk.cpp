@@ -0,0 +1,226 @@
+#include "thunk.h"
+
+#include <plugify/plugin_descriptor.h>
+
+using namespace monolm;
+using namespace plugify;
+using namespace asmjit;
+
+CallThunk::CallThunk(std::weak_ptr<JitRuntime> rt) : _rt{std::move(rt)} {
+}
+
+CallThunk::CallThunk(CallThunk&& other) noexcept : _rt{std::move(other._rt)}, _function{other._function}, _errorCode{std::move(other._errorCode)} {
+	other._function = nullptr;
+}
+
+CallThunk::~CallThunk() {
+	if (auto rt = _rt.lock()) {
+		if (_function)
+			rt->release(_function);
+	}
+}
+
+bool CallThunk::IsSupported(const Method& method) {
+#if ASMJIT_ARCH_X86 == 64
+	// Aggregates returned by value have platform specific return conventions, leave them to dyncall
+	return method.retType.type < ValueType::FirstPOD || method.retType.type > ValueType::LastPOD;
+#else
+	// Stub is emitted with x86::Compiler, other architectures (ARM64) always go through dyncall
+	(void) method;
+	return false;
+#endif
+}
+
+TypeId CallThunk::GetParamTypeId(const Property& param) {
+	if (param.ref)
+		return TypeId::kUIntPtr;
+
+	switch (param.type) {
+		case ValueType::Bool:
+		case ValueType::UInt8:
+			return TypeId::kUInt8;
+		case ValueType::Char8:
+		case ValueType::Int8:
+			return TypeId::kInt8;
+		case ValueType::Char16:
+		case ValueType::UInt16:
+			return TypeId::kUInt16;
+		case ValueType::Int16:
+			return TypeId::kInt16;
+		case ValueType::Int32:
+			return TypeId::kInt32;
+		case ValueType::UInt32:
+			return TypeId::kUInt32;
+		case ValueType::Int64:
+			return TypeId::kInt64;
+		case ValueType::UInt64:
+			return TypeId::kUInt64;
+		case ValueType::Float:
+			return TypeId::kFloat32;
+		case ValueType::Double:
+			return TypeId::kFloat64;
+		default:
+			// Pointers, delegates, strings, arrays and structs passed by pointer
+			return TypeId::kUIntPtr;
+	}
+}
+
+TypeId CallThunk::GetReturnTypeId(const Property& ret) {
+	// Strings and arrays are returned through the hidden storage slot
+	if (ret.type == ValueType::Void || (ret.type >= ValueType::FirstObject && ret.type <= ValueType::LastObject))
+		return TypeId::kVoid;
+	return GetParamTypeId(ret);
+}
+
+CallThunk::ThunkFunc CallThunk::GetJitFunc(const Method& method, void* addr) {
+	if (_function)
+		return _function;
+
+	if (!IsSupported(method)) {
+		_errorCode = "Return type is not supported by thunk";
+		return nullptr;
+	}
+
+	// Describe native target, first slot is the storage for object return (if any)
+	TypeId retTypeId = GetReturnTypeId(method.retType);
+
+	std::vector<TypeId> argTypeIds;
+	argTypeIds.reserve(method.paramTypes.size() + 1);
+	if (method.retType.type >= ValueType::FirstObject && method.retType.type <= ValueType::LastObject)
+		argTypeIds.push_back(TypeId::kUIntPtr);
+	for (const auto& param : method.paramTypes) {
+		argTypeIds.push_back(GetParamTypeId(param));
+	}
+
+	return GetJitFunc(argTypeIds, retTypeId, addr);
+}
+
+CallThunk::ThunkFunc CallThunk::GetJitFunc(std::span<const TypeId> argTypeIds, TypeId retTypeId, void* addr) {
+	if (_function)
+		return _function;
+
+#if ASMJIT_ARCH_X86 == 64
+	auto rt = _rt.lock();
+	if (!rt) {
+		_errorCode = "JitRuntime invalid";
+		return nullptr;
+	}
+
+	FuncSignature targetSig(CallConvId::kHost);
+	targetSig.setRet(retTypeId);
+	for (TypeId typeId : argTypeIds) {
+		targetSig.addArg(typeId);
+	}
+
+	CodeHolder code;
+	code.init(rt->environment(), rt->cpuFeatures());
+
+	x86::Compiler cc(&code);
+	FuncNode* func = cc.addFunc(FuncSignature::build<void, const NativeSlot*, NativeSlot*>());
+
+	x86::Gp argsPtr = cc.newUIntPtr();
+	x86::Gp retPtr = cc.newUIntPtr();
+	func->setArg(0, argsPtr);
+	func->setArg(1, retPtr);
+
+	// Load slots into virtual registers, the register allocator will place them into ABI registers
+	std::vector<BaseReg> argRegs;
+	argRegs.reserve(argTypeIds.size());
+	for (size_t i = 0; i < argTypeIds.size(); ++i) {
+		auto offset = static_cast<int32_t>(i * sizeof(NativeSlot));
+		switch (argTypeIds[i]) {
+			case TypeId::kFloat32: {
+				x86::Xmm reg = cc.newXmmSs();
+				cc.movss(reg, x86::dword_ptr(argsPtr, offset));
+				argRegs.push_back(reg);
+				break;
+			}
+			case TypeId::kFloat64: {
+				x86::Xmm reg = cc.newXmmSd();
+				cc.movsd(reg, x86::qword_ptr(argsPtr, offset));
+				argRegs.push_back(reg);
+				break;
+			}
+			// Narrow integers are extended to 32 bits, callees built by clang/gcc rely on it
+			case TypeId::kInt8: {
+				x86::Gp reg = cc.newInt32();
+				cc.movsx(reg, x86::byte_ptr(argsPtr, offset));
+				argRegs.push_back(reg);
+				break;
+			}
+			case TypeId::kUInt8: {
+				x86::Gp reg = cc.newUInt32();
+				cc.movzx(reg, x86::byte_ptr(argsPtr, offset));
+				argRegs.push_back(reg);
+				break;
+			}
+			case TypeId::kInt16: {
+				x86::Gp reg = cc.newInt32();
+				cc.movsx(reg, x86::word_ptr(argsPtr, offset));
+				argRegs.push_back(reg);
+				break;
+			}
+			case TypeId::kUInt16: {
+				x86::Gp reg = cc.newUInt32();
+				cc.movzx(reg, x86::word_ptr(argsPtr, offset));
+				argRegs.push_back(reg);
+				break;
+			}
+			default: {
+				x86::Gp reg = cc.newGp(argTypeIds[i]);
+				cc.mov(reg, x86::ptr(argsPtr, offset, reg.size()));
+				argRegs.push_back(reg);
+				break;
+			}
+		}
+	}
+
+	InvokeNode* invokeNode;
+	cc.invoke(&invokeNode, reinterpret_cast<uint64_t>(addr), targetSig);
+	for (size_t i = 0; i < argRegs.size(); ++i) {
+		invokeNode->setArg(i, argRegs[i]);
+	}
+
+	switch (retTypeId) {
+		case TypeId::kVoid:
+			break;
+		case TypeId::kFloat32: {
+			x86::Xmm reg = cc.newXmmSs();
+			invokeNode->setRet(0, reg);
+			cc.movss(x86::dword_ptr(retPtr), reg);
+			break;
+		}
+		case TypeId::kFloat64: {
+			x86::Xmm reg = cc.newXmmSd();
+			invokeNode->setRet(0, reg);
+			cc.movsd(x86::qword_ptr(retPtr), reg);
+			break;
+		}
+		default: {
+			x86::Gp reg = cc.newGp(retTypeId);
+			invokeNode->setRet(0, reg);
+			cc.mov(x86::ptr(retPtr, 0, reg.size()), reg);
+			break;
+		}
+	}
+
+	cc.ret();
+	cc.endFunc();
+	cc.finalize();
+
+	Error err = rt->add(&_function, &code);
+	if (err) {
+		_function = nullptr;
+		_errorCode = DebugUtils::errorAsString(err);
+		return nullptr;
+	}
+
+	return _function;
+#else
+	(void) argTypeIds;
+	(void) retTypeId;
+	(void) addr;
+	_errorCode = "Thunk is not supported on this architecture";
+	return nullptr;
+#endif
+}
\ No newline at end of file
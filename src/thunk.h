@@ -0,0 +1,58 @@
+#pragma once
+
+#include <asmjit/asmjit.h>
+
+namespace plugify {
+	struct Method;
+	struct Property;
+}
+
+namespace monolm {
+	/// Native slot type used to pass already marshalled arguments to the thunk.
+	/// Every argument occupies one 64-bit slot regardless of its real size.
+	using NativeSlot = uint64_t;
+
+	template<typename T>
+	void StoreSlot(NativeSlot& slot, T value) {
+		static_assert(sizeof(T) <= sizeof(NativeSlot));
+		slot = 0;
+		std::memcpy(&slot, &value, sizeof(T));
+	}
+
+	template<typename T>
+	T LoadSlot(const NativeSlot& slot) {
+		static_assert(sizeof(T) <= sizeof(NativeSlot));
+		T value;
+		std::memcpy(&value, &slot, sizeof(T));
+		return value;
+	}
+
+	/// Generates a specialized native stub for one plugify::Method which loads
+	/// the marshalled slots straight into ABI registers and calls the target.
+	class CallThunk {
+	public:
+		explicit CallThunk(std::weak_ptr<asmjit::JitRuntime> rt);
+		CallThunk(CallThunk&& other) noexcept;
+		~CallThunk();
+
+		using ThunkFunc = void(*)(const NativeSlot* args, NativeSlot* ret);
+
+		static bool IsSupported(const plugify::Method& method);
+
+		ThunkFunc GetJitFunc(const plugify::Method& method, void* addr);
+		/// Generic form, every argument and the return are described by asmjit type ids.
+		ThunkFunc GetJitFunc(std::span<const asmjit::TypeId> argTypeIds, asmjit::TypeId retTypeId, void* addr);
+
+		ThunkFunc GetFunction() const { return _function; }
+		const std::string& GetError() const { return _errorCode; }
+
+	private:
+		static asmjit::TypeId GetParamTypeId(const plugify::Property& param);
+		static asmjit::TypeId GetReturnTypeId(const plugify::Property& ret);
+
+	private:
+		std::weak_ptr<asmjit::JitRuntime> _rt;
+		ThunkFunc _function{ nullptr };
+		std::string _errorCode;
+	};
+}
\ No newline at end of file
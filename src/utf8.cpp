@@ -0,0 +1,171 @@
+#include "utf8.h"
+#include "kernels.h"
+
+using namespace monolm;
+
+namespace {
+	constexpr char32_t kReplacement = 0xFFFD;
+
+	bool IsHighSurrogate(char32_t c) { return c >= 0xD800 && c <= 0xDBFF; }
+	bool IsLowSurrogate(char32_t c) { return c >= 0xDC00 && c <= 0xDFFF; }
+	bool IsContinuation(uint8_t c) { return (c & 0xC0) == 0x80; }
+}
+
+void Utf8::FromUtf16(const char16_t* source, size_t length, std::string& dest) {
+	size_t ascii = ArrayKernels::FindNonAscii(source, length);
+	if (ascii == length) {
+		dest.resize(length);
+		ArrayKernels::NarrowChar16(source, dest.data(), length);
+		return;
+	}
+
+	// Measure the exact size first, so the destination is written only once
+	size_t size = ascii;
+	for (size_t i = ascii; i < length; ++i) {
+		char32_t c = source[i];
+		if (c < 0x80) {
+			size += 1;
+		} else if (c < 0x800) {
+			size += 2;
+		} else if (IsHighSurrogate(c) && i + 1 < length && IsLowSurrogate(source[i + 1])) {
+			size += 4;
+			++i;
+		} else {
+			size += 3;
+		}
+	}
+
+	dest.resize(size);
+	auto* out = reinterpret_cast<uint8_t*>(dest.data());
+	ArrayKernels::NarrowChar16(source, dest.data(), ascii);
+	out += ascii;
+
+	for (size_t i = ascii; i < length; ) {
+		char32_t c = source[i];
+		if (c < 0x80) {
+			size_t run = ArrayKernels::FindNonAscii(source + i, length - i);
+			ArrayKernels::NarrowChar16(source + i, reinterpret_cast<char*>(out), run);
+			out += run;
+			i += run;
+			continue;
+		}
+		out += Encode(source, length, i, out);
+	}
+}
+
+size_t Utf8::Encode(const char16_t* source, size_t length, size_t& i, uint8_t* out) {
+	char32_t c = source[i++];
+	if (c < 0x800) {
+		out[0] = static_cast<uint8_t>(0xC0 | (c >> 6));
+		out[1] = static_cast<uint8_t>(0x80 | (c & 0x3F));
+		return 2;
+	}
+	if (IsHighSurrogate(c) && i < length && IsLowSurrogate(source[i])) {
+		c = 0x10000 + ((c - 0xD800) << 10) + (source[i++] - 0xDC00);
+		out[0] = static_cast<uint8_t>(0xF0 | (c >> 18));
+		out[1] = static_cast<uint8_t>(0x80 | ((c >> 12) & 0x3F));
+		out[2] = static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F));
+		out[3] = static_cast<uint8_t>(0x80 | (c & 0x3F));
+		return 4;
+	}
+	if (IsHighSurrogate(c) || IsLowSurrogate(c))
+		c = kReplacement;
+	out[0] = static_cast<uint8_t>(0xE0 | (c >> 12));
+	out[1] = static_cast<uint8_t>(0x80 | ((c >> 6) & 0x3F));
+	out[2] = static_cast<uint8_t>(0x80 | (c & 0x3F));
+	return 3;
+}
+
+bool Utf8::Equals(const char16_t* source, size_t length, const char* dest, size_t size) {
+	// Every UTF-16 unit takes from one to three UTF-8 bytes
+	if (size < length || size > length * 3)
+		return false;
+
+	const auto* bytes = reinterpret_cast<const uint8_t*>(dest);
+	size_t j = 0;
+	for (size_t i = 0; i < length; ) {
+		if (source[i] < 0x80) {
+			// ASCII run is compared unit by unit, nothing to encode
+			size_t run = ArrayKernels::FindNonAscii(source + i, length - i);
+			if (size - j < run)
+				return false;
+			for (size_t k = 0; k < run; ++k) {
+				if (source[i + k] != bytes[j + k])
+					return false;
+			}
+			i += run;
+			j += run;
+			continue;
+		}
+		uint8_t encoded[4];
+		size_t count = Encode(source, length, i, encoded);
+		if (size - j < count || std::memcmp(encoded, bytes + j, count) != 0)
+			return false;
+		j += count;
+	}
+	return j == size;
+}
+
+char32_t Utf8::Decode(const uint8_t* source, size_t length, size_t& i) {
+	uint8_t lead = source[i++];
+	if (lead < 0x80)
+		return lead;
+
+	size_t extra;
+	char32_t c;
+	char32_t min;
+	if (lead >= 0xC2 && lead <= 0xDF) {
+		extra = 1; c = lead & 0x1F; min = 0x80;
+	} else if (lead >= 0xE0 && lead <= 0xEF) {
+		extra = 2; c = lead & 0x0F; min = 0x800;
+	} else if (lead >= 0xF0 && lead <= 0xF4) {
+		extra = 3; c = lead & 0x07; min = 0x10000;
+	} else {
+		return kReplacement;
+	}
+
+	if (length - i < extra)
+		return kReplacement;
+	for (size_t j = 0; j < extra; ++j) {
+		if (!IsContinuation(source[i + j]))
+			return kReplacement;
+		c = (c << 6) | (source[i + j] & 0x3F);
+	}
+	if (c < min || c > 0x10FFFF || IsHighSurrogate(c) || IsLowSurrogate(c))
+		return kReplacement;
+
+	i += extra;
+	return c;
+}
+
+size_t Utf8::GetUtf16Length(const char* source, size_t length) {
+	size_t i = ArrayKernels::FindNonAscii(source, length);
+	size_t size = i;
+	const auto* bytes = reinterpret_cast<const uint8_t*>(source);
+	while (i < length) {
+		size += Decode(bytes, length, i) >= 0x10000 ? 2 : 1;
+	}
+	return size;
+}
+
+void Utf8::ToUtf16(const char* source, size_t length, char16_t* dest) {
+	const auto* bytes = reinterpret_cast<const uint8_t*>(source);
+	size_t i = 0;
+	while (i < length) {
+		if (bytes[i] < 0x80) {
+			size_t run = ArrayKernels::FindNonAscii(source + i, length - i);
+			ArrayKernels::WidenChar8(source + i, dest, run);
+			dest += run;
+			i += run;
+			continue;
+		}
+		char32_t c = Decode(bytes, length, i);
+		if (c >= 0x10000) {
+			c -= 0x10000;
+			*dest++ = static_cast<char16_t>(0xD800 + (c >> 10));
+			*dest++ = static_cast<char16_t>(0xDC00 + (c & 0x3FF));
+		} else {
+			*dest++ = static_cast<char16_t>(c);
+		}
+	}
+}
\ No newline at end of file
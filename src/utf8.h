@@ -0,0 +1,24 @@
+#pragma once
+
+namespace monolm {
+	/// UTF-16 <-> UTF-8 transcoder working directly on managed string storage.
+	/// ASCII runs are detected and converted with SIMD kernels, ill-formed input is replaced with U+FFFD.
+	class Utf8 {
+	public:
+		Utf8() = delete;
+
+		static void FromUtf16(const char16_t* source, size_t length, std::string& dest);
+
+		static size_t GetUtf16Length(const char* source, size_t length);
+		/// dest must hold GetUtf16Length(source, length) elements.
+		static void ToUtf16(const char* source, size_t length, char16_t* dest);
+
+		/// Same result as comparing FromUtf16(source) with dest, but without transcoding into a temporary.
+		static bool Equals(const char16_t* source, size_t length, const char* dest, size_t size);
+
+	private:
+		static char32_t Decode(const uint8_t* source, size_t length, size_t& i);
+		/// Encodes non-ASCII code point starting at source[i] (surrogate pair consumes two units), returns written bytes.
+		static size_t Encode(const char16_t* source, size_t length, size_t& i, uint8_t* out);
+	};
+}
\ No newline at end of file
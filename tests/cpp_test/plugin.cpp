@@ -4,6 +4,32 @@
 #include <pps/CSharpTest.h>
 #include <cassert>
 
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// Entry points of the language module which plugify does not expose to plugins
+template<typename F>
+F GetModuleFunction(const char* name) {
+#if defined(_WIN32)
+    return reinterpret_cast<F>(GetProcAddress(GetModuleHandleA("mono-lang-module.dll"), name));
+#else
+#if defined(__APPLE__)
+    void* module = dlopen("libmono-lang-module.dylib", RTLD_NOW | RTLD_NOLOAD);
+#else
+    void* module = dlopen("libmono-lang-module.so", RTLD_NOW | RTLD_NOLOAD);
+#endif
+    if (!module)
+        return nullptr;
+    auto function = reinterpret_cast<F>(dlsym(module, name));
+    dlclose(module);
+    return function;
+#endif
+}
+
 class CppTestPlugin : public plugify::IPluginEntry {
 public:
     void OnPluginStart() override {
@@ -191,6 +217,320 @@ public:
 
             assert((returnValue == 56));
         }
+
+        // Round trips through array kernels, lengths around the 8/16/32 element blocks of scalar, SSE2 and AVX2 paths
+        {
+            const size_t lengths[] = { 0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100 };
+            for (size_t length : lengths) {
+                // std::vector<bool> goes through its public interface, lengths which end mid word included
+                std::vector<bool> bools(length);
+                for (size_t i = 0; i < length; ++i) {
+                    bools[i] = (i * 7 + length) % 3 == 0;
+                }
+                assert((CSharpTest::RoundTripArrayBool(bools) == bools));
+
+                // char is widened to System.Char and narrowed back, negative values included
+                std::vector<char> chars(length);
+                for (size_t i = 0; i < length; ++i) {
+                    chars[i] = static_cast<char>(i * 37 + length);
+                }
+                assert((CSharpTest::RoundTripArrayChar8(chars) == chars));
+            }
+        }
+
+        // UTF-8 <-> UTF-16 codec
+        {
+            auto replacement = [](size_t count) {
+                std::string result;
+                for (size_t i = 0; i < count; ++i) {
+                    result += "\xEF\xBF\xBD"; // U+FFFD
+                }
+                return result;
+            };
+
+            // Well-formed text of every sequence length comes back unchanged
+            const std::string valid[] = {
+                "",
+                "ascii only",
+                "\xD0\x9F\xD1\x80\xD0\xB8", // 2 bytes
+                "\xE6\x97\xA5\xE6\x9C\xAC", // 3 bytes
+                "\xF0\x9F\x98\x80", // 4 bytes, surrogate pair on managed side
+                "\xEF\xBF\xBD", // U+FFFD itself
+                std::string(31, 'a') + "\xC3\xA9" + std::string(33, 'b'), // non-ASCII right after SIMD block
+                std::string(100, 'x'),
+            };
+            for (const auto& text : valid) {
+                assert((CSharpTest::RoundTripString(text) == text));
+            }
+            assert((CSharpTest::GetStringLength("\xF0\x9F\x98\x80") == 2));
+
+            // Ill-formed input, every byte which does not start a valid sequence becomes U+FFFD
+            assert((CSharpTest::RoundTripString("\xC0\xAF") == replacement(2))); // overlong '/'
+            assert((CSharpTest::RoundTripString("\xE0\x80\xAF") == replacement(3))); // overlong '/'
+            assert((CSharpTest::RoundTripString("\xED\xA0\x80") == replacement(3))); // encoded surrogate
+            assert((CSharpTest::RoundTripString("\xF4\x90\x80\x80") == replacement(4))); // above U+10FFFF
+            assert((CSharpTest::RoundTripString("\x80") == replacement(1))); // stray continuation
+            assert((CSharpTest::RoundTripString("a\xE6\x97") == "a" + replacement(2))); // truncated at the end
+            assert((CSharpTest::RoundTripString("\xE6\x97" "b") == replacement(2) + "b")); // truncated in the middle
+            assert((CSharpTest::GetStringLength("\xC0\xAF") == 2));
+
+            // Lone surrogates of managed string are replaced as well
+            assert((CSharpTest::ReturnLoneSurrogates() == "a" + replacement(1) + "b" + replacement(3) + "c" + replacement(1)));
+        }
+
+        // Jagged arrays: rows, row offsets, string offsets (string[][] only), then data aligned to 8 bytes
+        {
+            auto append = [](std::vector<uint8_t>& buffer, const void* data, size_t size) {
+                const auto* bytes = static_cast<const uint8_t*>(data);
+                buffer.insert(buffer.end(), bytes, bytes + size);
+            };
+            auto appendOffsets = [&append](std::vector<uint8_t>& buffer, const std::vector<size_t>& sizes) {
+                uint32_t offset = 0;
+                for (size_t size : sizes) {
+                    append(buffer, &offset, sizeof(offset));
+                    offset += static_cast<uint32_t>(size);
+                }
+                append(buffer, &offset, sizeof(offset));
+            };
+            auto packInts = [&](const std::vector<std::vector<int32_t>>& rows) {
+                std::vector<uint8_t> buffer;
+                auto count = static_cast<uint32_t>(rows.size());
+                append(buffer, &count, sizeof(count));
+                std::vector<size_t> rowSizes;
+                for (const auto& row : rows) {
+                    rowSizes.push_back(row.size());
+                }
+                appendOffsets(buffer, rowSizes);
+                buffer.resize((buffer.size() + 7) & ~size_t{7});
+                for (const auto& row : rows) {
+                    append(buffer, row.data(), row.size() * sizeof(int32_t));
+                }
+                return buffer;
+            };
+            auto packStrings = [&](const std::vector<std::vector<std::string>>& rows) {
+                std::vector<uint8_t> buffer;
+                auto count = static_cast<uint32_t>(rows.size());
+                append(buffer, &count, sizeof(count));
+                std::vector<size_t> rowSizes;
+                std::vector<size_t> stringSizes;
+                for (const auto& row : rows) {
+                    rowSizes.push_back(row.size());
+                    for (const auto& element : row) {
+                        stringSizes.push_back(element.size());
+                    }
+                }
+                appendOffsets(buffer, rowSizes);
+                appendOffsets(buffer, stringSizes);
+                buffer.resize((buffer.size() + 7) & ~size_t{7});
+                for (const auto& row : rows) {
+                    for (const auto& element : row) {
+                        append(buffer, element.data(), element.size());
+                    }
+                }
+                return buffer;
+            };
+
+            auto ints = packInts({ { 1, 2, 3 }, {}, { -4 }, {}, { 5, 6, 7, 8, 9 } });
+            assert((CSharpTest::RoundTripJaggedInt(ints) == ints));
+            auto noRows = packInts({});
+            assert((CSharpTest::RoundTripJaggedInt(noRows) == noRows));
+
+            // Null rows are packed as empty ones
+            assert((CSharpTest::ReturnJaggedWithNullRow() == packInts({ { 1, 2 }, {}, {}, { 3 } })));
+
+            auto strings = packStrings({ { "first", "", "\xE6\x97\xA5" }, {}, { "last row" } });
+            assert((CSharpTest::RoundTripJaggedString(strings) == strings));
+        }
+
+        // Narrow integers are sign or zero extended by call thunk, floats go through xmm registers
+        {
+            assert((CSharpTest::ParamNarrowSum(std::numeric_limits<int8_t>::min(), std::numeric_limits<uint8_t>::max(), std::numeric_limits<int16_t>::min(), std::numeric_limits<uint16_t>::max(), true, std::numeric_limits<char16_t>::max(), 1.5f, -2.25) == 98429.25));
+            assert((CSharpTest::ParamNarrowSum(-1, 1, -1, 1, false, u'A', -0.5f, 0.25) == 64.75));
+        }
+
+        // Batch form runs the loop in managed code, column i holds the values of parameter i
+        {
+            using GetMethodBatchFn = void* (*)(void*);
+            using MulAddBatchFn = void (*)(const void* const*, void*, int32_t);
+            auto getMethodBatch = GetModuleFunction<GetMethodBatchFn>("GetMethodBatch");
+            assert(getMethodBatch != nullptr);
+            auto batch = reinterpret_cast<MulAddBatchFn>(getMethodBatch(plugify::GetMethodPtr("CSharpTest.MulAdd")));
+            assert(batch != nullptr);
+
+            const int32_t a[] = { 1, -2, 3, 0, 5, std::numeric_limits<int32_t>::min() };
+            const float b[] = { 0.5f, 1.5f, -2.0f, 4.0f, 0.25f, 1.0f };
+            const double c[] = { 1.0, 2.0, 3.0, -4.0, 0.125, 0.0 };
+            const void* columns[] = { a, b, c };
+            double results[std::size(a)] = {};
+            batch(columns, results, static_cast<int32_t>(std::size(a)));
+            for (size_t i = 0; i < std::size(a); ++i) {
+                assert((results[i] == static_cast<float>(a[i]) * b[i] + c[i]));
+            }
+
+            // Strings and arrays have no batch form
+            assert((getMethodBatch(plugify::GetMethodPtr("CSharpTest.RoundTripString")) == nullptr));
+        }
+
+        // User structs are passed by pointer, arrays of them as raw bytes
+        {
+            struct TestPoint {
+                int32_t x, y;
+                float weight;
+            };
+
+            TestPoint point{ 3, 4, 0.5f };
+            assert((CSharpTest::GetPointWeight(&point) == 3.5f));
+            CSharpTest::MovePoint(&point, 10, -20);
+            assert((point.x == 13 && point.y == -16 && point.weight == 0.5f));
+            assert((CSharpTest::GetPointWeight(nullptr) == 0.0f));
+
+            const TestPoint points[] = { { 1, 2, 0.0f }, { -3, 4, 0.0f }, { 5, 6, 0.0f } };
+            std::vector<uint8_t> bytes(reinterpret_cast<const uint8_t*>(points), reinterpret_cast<const uint8_t*>(points) + sizeof(points));
+            assert((CSharpTest::SumPoints(bytes) == 15));
+            assert((CSharpTest::SumPoints({}) == 0));
+
+            // Partial trailing element is rejected and C# receives null
+            bytes.pop_back();
+            assert((CSharpTest::SumPoints(bytes) == -1));
+        }
+
+        // Vector3[] and Matrix4x4[] are flat float arrays, N elements are 3N or 16N floats
+        {
+            std::vector<float> vectors = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+            assert((CSharpTest::CountVector3(vectors) == 3));
+            assert((CSharpTest::RoundTripVector3Array(vectors) == vectors));
+            assert((CSharpTest::CountVector3({}) == 0));
+
+            std::vector<float> matrices(32);
+            for (size_t i = 0; i < matrices.size(); ++i) {
+                matrices[i] = static_cast<float>(i);
+            }
+            std::vector<float> transposed(32);
+            for (size_t m = 0; m < 2; ++m) {
+                for (size_t row = 0; row < 4; ++row) {
+                    for (size_t column = 0; column < 4; ++column) {
+                        transposed[m * 16 + column * 4 + row] = matrices[m * 16 + row * 4 + column];
+                    }
+                }
+            }
+            assert((CSharpTest::TransposeMatrices(matrices) == transposed));
+
+            // Ref array is replaced by a longer one
+            std::vector<float> points = { 1, 2, 3, 4 };
+            CSharpTest::AppendVector2(points);
+            assert((points == std::vector<float>{ 1, 2, 3, 4, 2, -2 }));
+
+            // Float count which is not a multiple of the element size is rejected and C# receives null
+            assert((CSharpTest::CountVector3({ 1, 2, 3, 4 }) == -1));
+            assert((CSharpTest::RoundTripVector3Array({ 1, 2, 3, 4 }).empty()));
+            assert((CSharpTest::TransposeMatrices(std::vector<float>(20)).empty()));
+        }
+
+        // Into forms write string and array returns into storage kept by the caller
+        {
+            struct OutputBuffer {
+                void* data;
+                size_t capacity;
+                size_t size;
+            };
+
+            using GetMethodIntoFn = void* (*)(void*);
+            auto getMethodInto = GetModuleFunction<GetMethodIntoFn>("GetMethodInto");
+            auto getMethodIntoBuffer = GetModuleFunction<GetMethodIntoFn>("GetMethodIntoBuffer");
+            assert(getMethodInto != nullptr && getMethodIntoBuffer != nullptr);
+
+            // Container form, hidden return points to a constructed container which is assigned in place
+            using RepeatStringIntoFn = std::string* (*)(std::string*, const std::string&, int32_t);
+            using MakeRangeIntoFn = std::vector<int32_t>* (*)(std::vector<int32_t>*, int32_t);
+            auto repeatInto = reinterpret_cast<RepeatStringIntoFn>(getMethodInto(plugify::GetMethodPtr("CSharpTest.RepeatString")));
+            auto rangeInto = reinterpret_cast<MakeRangeIntoFn>(getMethodInto(plugify::GetMethodPtr("CSharpTest.MakeRange")));
+            assert(repeatInto != nullptr && rangeInto != nullptr);
+
+            std::string text;
+            text.reserve(64);
+            const char* textData = text.data();
+            assert((repeatInto(&text, "ab", 3) == &text));
+            assert((text == "ababab"));
+            assert((*repeatInto(&text, "\xE6\x97\xA5", 2) == "\xE6\x97\xA5\xE6\x97\xA5"));
+            assert((text.data() == textData));
+            assert((repeatInto(&text, "ab", 0)->empty()));
+
+            std::vector<int32_t> numbers;
+            numbers.reserve(16);
+            const int32_t* numbersData = numbers.data();
+            assert((*rangeInto(&numbers, 5) == std::vector<int32_t>{ 0, 1, 2, 3, 4 }));
+            assert((*rangeInto(&numbers, 3) == std::vector<int32_t>{ 0, 1, 2 }));
+            assert((numbers.data() == numbersData));
+            assert((rangeInto(&numbers, -1)->empty())); // null result clears the container
+
+            // Buffer form, at most capacity elements are written and size receives the full length
+            using RepeatStringBufferFn = OutputBuffer* (*)(OutputBuffer*, const std::string&, int32_t);
+            using MakeRangeBufferFn = OutputBuffer* (*)(OutputBuffer*, int32_t);
+            auto repeatBuffer = reinterpret_cast<RepeatStringBufferFn>(getMethodIntoBuffer(plugify::GetMethodPtr("CSharpTest.RepeatString")));
+            auto rangeBuffer = reinterpret_cast<MakeRangeBufferFn>(getMethodIntoBuffer(plugify::GetMethodPtr("CSharpTest.MakeRange")));
+            assert(repeatBuffer != nullptr && rangeBuffer != nullptr);
+
+            char chars[4] = {};
+            OutputBuffer buffer{ chars, std::size(chars), 0 };
+            assert((repeatBuffer(&buffer, "ab", 1) == &buffer));
+            assert((buffer.size == 2 && std::string_view(chars, 2) == "ab"));
+            repeatBuffer(&buffer, "xyz", 2);
+            assert((buffer.size == 6 && std::string_view(chars, 4) == "xyzx"));
+
+            int32_t ints[4] = {};
+            buffer = { ints, std::size(ints), 0 };
+            rangeBuffer(&buffer, 3);
+            assert((buffer.size == 3 && ints[0] == 0 && ints[1] == 1 && ints[2] == 2));
+            rangeBuffer(&buffer, 6);
+            assert((buffer.size == 6 && ints[3] == 3));
+
+            // Primitive returns have no into form and arrays of strings have no buffer form
+            assert((getMethodInto(plugify::GetMethodPtr("CSharpTest.ParamNarrowSum")) == nullptr));
+            assert((getMethodInto(plugify::GetMethodPtr("CSharpTest.NoParamReturnArrayString")) != nullptr));
+            assert((getMethodIntoBuffer(plugify::GetMethodPtr("CSharpTest.NoParamReturnArrayString")) == nullptr));
+        }
+
+        // Native views read the caller's containers in place, NativeVector<T> also resizes and appends
+        {
+            std::vector<int32_t> ints = { 5, 6 };
+            assert((CSharpTest::GrowVector(ints) == 5));
+            assert((ints == std::vector<int32_t>{ -5, 6, 2, 0, 7 }));
+            std::vector<int32_t> empty;
+            assert((CSharpTest::GrowVector(empty) == 3));
+            assert((empty == std::vector<int32_t>{ 0, 0, 7 }));
+
+            // Appends past the capacity reallocate the native buffer
+            std::vector<int32_t> full(64, 1);
+            full.shrink_to_fit();
+            assert((CSharpTest::GrowVector(full) == 67));
+            assert((full.size() == 67 && full[0] == -1 && full[63] == 1 && full[64] == 64 && full[65] == 0 && full[66] == 7));
+
+            std::string text = std::string(40, 'a');
+            CSharpTest::AppendBytes(text);
+            assert((text == std::string(40, 'a') + "!"));
+
+            std::vector<double> doubles = { 1.0, 2.0 };
+            CSharpTest::ClearVector(doubles);
+            assert((doubles.empty()));
+
+            assert((CSharpTest::SumSpan({ 1, -2, std::numeric_limits<int32_t>::max(), 4 }) == 2147483650));
+            assert((CSharpTest::SumSpan({}) == 0));
+            assert((CSharpTest::CountSpaces("a b  c ") == 4));
+            assert((CSharpTest::CountSpaces("") == 0));
+        }
+
+        // NativeStringList decodes elements on first access and outlives the call
+        {
+            assert((CSharpTest::JoinStrings({ "first", "", "\xE6\x97\xA5\xE6\x9C\xAC", "last" }) == "4:first||\xE6\x97\xA5\xE6\x9C\xAC|last:last"));
+            assert((CSharpTest::JoinStrings({}) == "0::"));
+
+            std::vector<std::string> kept = { "kept", "\xF0\x9F\x98\x80", std::string(100, 'x') };
+            CSharpTest::KeepStrings(kept);
+            kept.assign(3, "overwritten");
+            assert((CSharpTest::GetKeptString(1) == "\xF0\x9F\x98\x80"));
+            assert((CSharpTest::GetKeptString(2) == std::string(100, 'x')));
+            assert((CSharpTest::GetKeptString(0) == "kept"));
+        }
     }
 };
 
@@ -286,4 +286,124 @@ namespace CSharpTest {
 		static auto func = reinterpret_cast<ParamAllPrimitivesFn>(plugify::GetMethodPtr("CSharpTest.ParamAllPrimitives"));
 		return func(p1, p2, p3, p4, p5, p6, p7, p8, p9, p10, p11, p12, p13);
 	}
+	inline std::vector<bool> RoundTripArrayBool(const std::vector<bool>& a) {
+		using RoundTripArrayBoolFn = std::vector<bool> (*)(const std::vector<bool>&);
+		static auto func = reinterpret_cast<RoundTripArrayBoolFn>(plugify::GetMethodPtr("CSharpTest.RoundTripArrayBool"));
+		return func(a);
+	}
+	inline std::vector<char> RoundTripArrayChar8(const std::vector<char>& a) {
+		using RoundTripArrayChar8Fn = std::vector<char> (*)(const std::vector<char>&);
+		static auto func = reinterpret_cast<RoundTripArrayChar8Fn>(plugify::GetMethodPtr("CSharpTest.RoundTripArrayChar8"));
+		return func(a);
+	}
+	inline std::string RoundTripString(const std::string& a) {
+		using RoundTripStringFn = std::string (*)(const std::string&);
+		static auto func = reinterpret_cast<RoundTripStringFn>(plugify::GetMethodPtr("CSharpTest.RoundTripString"));
+		return func(a);
+	}
+	inline int32_t GetStringLength(const std::string& a) {
+		using GetStringLengthFn = int32_t (*)(const std::string&);
+		static auto func = reinterpret_cast<GetStringLengthFn>(plugify::GetMethodPtr("CSharpTest.GetStringLength"));
+		return func(a);
+	}
+	inline std::string ReturnLoneSurrogates() {
+		using ReturnLoneSurrogatesFn = std::string (*)();
+		static auto func = reinterpret_cast<ReturnLoneSurrogatesFn>(plugify::GetMethodPtr("CSharpTest.ReturnLoneSurrogates"));
+		return func();
+	}
+	inline std::vector<uint8_t> RoundTripJaggedInt(const std::vector<uint8_t>& a) {
+		using RoundTripJaggedIntFn = std::vector<uint8_t> (*)(const std::vector<uint8_t>&);
+		static auto func = reinterpret_cast<RoundTripJaggedIntFn>(plugify::GetMethodPtr("CSharpTest.RoundTripJaggedInt"));
+		return func(a);
+	}
+	inline std::vector<uint8_t> RoundTripJaggedString(const std::vector<uint8_t>& a) {
+		using RoundTripJaggedStringFn = std::vector<uint8_t> (*)(const std::vector<uint8_t>&);
+		static auto func = reinterpret_cast<RoundTripJaggedStringFn>(plugify::GetMethodPtr("CSharpTest.RoundTripJaggedString"));
+		return func(a);
+	}
+	inline std::vector<uint8_t> ReturnJaggedWithNullRow() {
+		using ReturnJaggedWithNullRowFn = std::vector<uint8_t> (*)();
+		static auto func = reinterpret_cast<ReturnJaggedWithNullRowFn>(plugify::GetMethodPtr("CSharpTest.ReturnJaggedWithNullRow"));
+		return func();
+	}
+	inline double ParamNarrowSum(int8_t a, uint8_t b, int16_t c, uint16_t d, bool e, char16_t f, float g, double h) {
+		using ParamNarrowSumFn = double (*)(int8_t, uint8_t, int16_t, uint16_t, bool, char16_t, float, double);
+		static auto func = reinterpret_cast<ParamNarrowSumFn>(plugify::GetMethodPtr("CSharpTest.ParamNarrowSum"));
+		return func(a, b, c, d, e, f, g, h);
+	}
+	inline float GetPointWeight(void* p) {
+		using GetPointWeightFn = float (*)(void*);
+		static auto func = reinterpret_cast<GetPointWeightFn>(plugify::GetMethodPtr("CSharpTest.GetPointWeight"));
+		return func(p);
+	}
+	inline void MovePoint(void* p, int32_t dx, int32_t dy) {
+		using MovePointFn = void (*)(void*, int32_t, int32_t);
+		static auto func = reinterpret_cast<MovePointFn>(plugify::GetMethodPtr("CSharpTest.MovePoint"));
+		func(p, dx, dy);
+	}
+	inline int32_t SumPoints(const std::vector<uint8_t>& points) {
+		using SumPointsFn = int32_t (*)(const std::vector<uint8_t>&);
+		static auto func = reinterpret_cast<SumPointsFn>(plugify::GetMethodPtr("CSharpTest.SumPoints"));
+		return func(points);
+	}
+	inline std::vector<float> RoundTripVector3Array(const std::vector<float>& a) {
+		using RoundTripVector3ArrayFn = std::vector<float> (*)(const std::vector<float>&);
+		static auto func = reinterpret_cast<RoundTripVector3ArrayFn>(plugify::GetMethodPtr("CSharpTest.RoundTripVector3Array"));
+		return func(a);
+	}
+	inline std::vector<float> TransposeMatrices(const std::vector<float>& a) {
+		using TransposeMatricesFn = std::vector<float> (*)(const std::vector<float>&);
+		static auto func = reinterpret_cast<TransposeMatricesFn>(plugify::GetMethodPtr("CSharpTest.TransposeMatrices"));
+		return func(a);
+	}
+	inline int32_t CountVector3(const std::vector<float>& a) {
+		using CountVector3Fn = int32_t (*)(const std::vector<float>&);
+		static auto func = reinterpret_cast<CountVector3Fn>(plugify::GetMethodPtr("CSharpTest.CountVector3"));
+		return func(a);
+	}
+	inline void AppendVector2(std::vector<float>& a) {
+		using AppendVector2Fn = void (*)(std::vector<float>&);
+		static auto func = reinterpret_cast<AppendVector2Fn>(plugify::GetMethodPtr("CSharpTest.AppendVector2"));
+		func(a);
+	}
+	inline int32_t GrowVector(std::vector<int32_t>& v) {
+		using GrowVectorFn = int32_t (*)(std::vector<int32_t>&);
+		static auto func = reinterpret_cast<GrowVectorFn>(plugify::GetMethodPtr("CSharpTest.GrowVector"));
+		return func(v);
+	}
+	inline void AppendBytes(std::string& s) {
+		using AppendBytesFn = void (*)(std::string&);
+		static auto func = reinterpret_cast<AppendBytesFn>(plugify::GetMethodPtr("CSharpTest.AppendBytes"));
+		func(s);
+	}
+	inline void ClearVector(std::vector<double>& v) {
+		using ClearVectorFn = void (*)(std::vector<double>&);
+		static auto func = reinterpret_cast<ClearVectorFn>(plugify::GetMethodPtr("CSharpTest.ClearVector"));
+		func(v);
+	}
+	inline int64_t SumSpan(const std::vector<int64_t>& s) {
+		using SumSpanFn = int64_t (*)(const std::vector<int64_t>&);
+		static auto func = reinterpret_cast<SumSpanFn>(plugify::GetMethodPtr("CSharpTest.SumSpan"));
+		return func(s);
+	}
+	inline int32_t CountSpaces(const std::string& s) {
+		using CountSpacesFn = int32_t (*)(const std::string&);
+		static auto func = reinterpret_cast<CountSpacesFn>(plugify::GetMethodPtr("CSharpTest.CountSpaces"));
+		return func(s);
+	}
+	inline std::string JoinStrings(const std::vector<std::string>& list) {
+		using JoinStringsFn = std::string (*)(const std::vector<std::string>&);
+		static auto func = reinterpret_cast<JoinStringsFn>(plugify::GetMethodPtr("CSharpTest.JoinStrings"));
+		return func(list);
+	}
+	inline void KeepStrings(const std::vector<std::string>& list) {
+		using KeepStringsFn = void (*)(const std::vector<std::string>&);
+		static auto func = reinterpret_cast<KeepStringsFn>(plugify::GetMethodPtr("CSharpTest.KeepStrings"));
+		func(list);
+	}
+	inline std::string GetKeptString(int32_t index) {
+		using GetKeptStringFn = std::string (*)(int32_t);
+		static auto func = reinterpret_cast<GetKeptStringFn>(plugify::GetMethodPtr("CSharpTest.GetKeptString"));
+		return func(index);
+	}
 }
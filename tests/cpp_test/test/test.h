@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 #include <iostream>
 #include <format>
@@ -451,3 +452,64 @@ extern "C" PLUGIN_API int64_t ParamAllPrimitives(bool p1, char16_t p2, int8_t p3
     sum += static_cast<int64_t>(p13);
     return sum;
 }	
+
+
+// Params (partially modified refs)
+
+extern "C" PLUGIN_API void ParamRefPartialUpdate(std::string& p1, std::string& p2, std::vector<std::string>& p3, std::vector<char>& p4, std::vector<bool>& p5)
+{
+    // p1 and p4 are left as is, p3 and p5 keep their length
+    p2 = "changed";
+    if (p3.size() > 2)
+        p3[2] = "replaced";
+    if (p5.size() > 1)
+        p5[1] = !p5[1];
+}
+
+// Narrow integers and floats (call thunks)
+
+extern "C" PLUGIN_API double ParamNarrowSum(int8_t a, uint8_t b, int16_t c, uint16_t d, bool e, char16_t f, float g, double h)
+{
+    return static_cast<float>(a + b + c + d + (e ? 1 : 0) + f) + g + h;
+}
+
+// Batch calls
+
+extern "C" PLUGIN_API double MulAdd(int32_t a, float b, double c)
+{
+    return static_cast<float>(a) * b + c;
+}
+
+extern "C" PLUGIN_API void RepeatString(std::string& output, const std::string& s, int32_t count)
+{
+    std::string result;
+    for (int32_t i = 0; i < count; ++i) {
+        result += s;
+    }
+    std::construct_at<>(&output, std::move(result));
+}
+
+// Array streams
+
+extern "C" PLUGIN_API void ReturnLargeArray(std::vector<int32_t>& output, int32_t count)
+{
+    std::vector<int32_t> result(static_cast<size_t>(count));
+    for (int32_t i = 0; i < count; ++i) {
+        result[static_cast<size_t>(i)] = i * 3 - 1;
+    }
+    std::construct_at<>(&output, std::move(result));
+}
+
+// Producer of 1000 squares, writes elements on demand
+extern "C" PLUGIN_API uint64_t ProduceSquares(void* buffer, uint64_t offset, uint64_t capacity)
+{
+    constexpr uint64_t total = 1000;
+    if (offset >= total)
+        return 0;
+    uint64_t count = std::min(capacity, total - offset);
+    auto* dest = static_cast<int32_t*>(buffer);
+    for (uint64_t i = 0; i < count; ++i) {
+        dest[i] = static_cast<int32_t>((offset + i) * (offset + i));
+    }
+    return count;
+}
\ No newline at end of file
@@ -211,6 +211,144 @@ namespace CSharpTest
 		        Assert(returnValue == 56, $"Expected return value to be 56, but got {returnValue}");
 	        }
 	        
+	        // Params (partially modified refs), unchanged values keep their managed objects
+	        {
+		        string unchangedString = "h\u00e9llo \U0001F600";
+		        string changedString = "before";
+		        string[] partialStrings = { "ascii", "\u65e5\u672c", "old" };
+		        char[] unchangedChars = { 'a', 'b', 'c' };
+		        bool[] partialBools = { true, false, true, false, true, false, true, false, true };
+
+		        string originalString = unchangedString;
+		        string[] originalStrings = partialStrings;
+		        string firstString = partialStrings[0];
+		        string secondString = partialStrings[1];
+		        char[] originalChars = unchangedChars;
+		        bool[] originalBools = partialBools;
+
+		        ParamRefPartialUpdate(ref unchangedString, ref changedString, ref partialStrings, ref unchangedChars, ref partialBools);
+
+				Assert(ReferenceEquals(unchangedString, originalString), "Expected unchanged string to keep its instance");
+				Assert(changedString == "changed", $"Expected changedString to be 'changed', but got {changedString}");
+				Assert(ReferenceEquals(partialStrings, originalStrings), "Expected string array of the same length to be updated in place");
+				Assert(ReferenceEquals(partialStrings[0], firstString) && ReferenceEquals(partialStrings[1], secondString), "Expected unchanged string elements to keep their instances");
+				Assert(partialStrings[2] == "replaced", $"Expected partialStrings[2] to be 'replaced', but got {partialStrings[2]}");
+				Assert(ReferenceEquals(unchangedChars, originalChars) && unchangedChars.SequenceEqual(new char[] { 'a', 'b', 'c' }), $"Expected unchangedChars to be kept as ('a', 'b', 'c'), but got {string.Join(", ", unchangedChars)}");
+				Assert(ReferenceEquals(partialBools, originalBools) && partialBools.SequenceEqual(new bool[] { true, true, true, false, true, false, true, false, true }), $"Expected partialBools to be updated in place, but got {string.Join(", ", partialBools)}");
+	        }
+	        
+	        // Narrow integers are sign or zero extended by call thunk, floats go through xmm registers
+	        {
+		        double sum = ParamNarrowSum(sbyte.MinValue, byte.MaxValue, short.MinValue, ushort.MaxValue, true, char.MaxValue, 1.5f, -2.25);
+				Assert(sum == 98429.25, $"Expected ParamNarrowSum() to return 98429.25, but got {sum}");
+		        sum = ParamNarrowSum(-1, 1, -1, 1, false, 'A', -0.5f, 0.25);
+				Assert(sum == 64.75, $"Expected ParamNarrowSum() to return 64.75, but got {sum}");
+	        }
+	        
+	        // Batch calls cross into native code once for all rows
+	        {
+		        int[] a = { 1, -2, 3, 0, 5, int.MinValue };
+		        float[] b = { 0.5f, 1.5f, -2.0f, 4.0f, 0.25f, 1.0f };
+		        double[] c = { 1.0, 2.0, 3.0, -4.0, 0.125, 0.0 };
+		        double[] sums = NativeBatch.InvokeBatch<double>("cpp_test", "MulAdd", a, b, c);
+				Assert(sums.SequenceEqual(a.Select((x, i) => x * b[i] + c[i])), $"Expected InvokeBatch(MulAdd) to match single calls, but got {string.Join(", ", sums)}");
+				Assert(sums.SequenceEqual(a.Select((x, i) => MulAdd(x, b[i], c[i]))), "Expected InvokeBatch(MulAdd) to match single calls");
+				Assert(NativeBatch.InvokeBatch<double>("cpp_test", "MulAdd", new int[0], new float[0], new double[0]).Length == 0, "Expected InvokeBatch() over empty columns to return empty array");
+
+		        string[] repeated = NativeBatch.InvokeBatch<string>("cpp_test", "RepeatString", new[] { "ab", "\u65e5", "x" }, new[] { 2, 1, 0 });
+				Assert(repeated.SequenceEqual(new[] { "abab", "\u65e5", "" }), $"Expected InvokeBatch(RepeatString) to return ('abab', '\u65e5', ''), but got {string.Join(", ", repeated)}");
+
+		        // Column count and lengths are checked before the call
+				Assert(NativeBatch.InvokeBatch("cpp_test", "MulAdd", a, b) == null, "Expected InvokeBatch() with missing column to return null");
+				Assert(NativeBatch.InvokeBatch("cpp_test", "MulAdd", a, b, new double[1]) == null, "Expected InvokeBatch() with short column to return null");
+	        }
+	        
+	        // Array streams copy native arrays out in chunks through one reused buffer
+	        {
+		        using (NativeArrayStream stream = ReturnLargeArray(10000))
+		        {
+					Assert(stream.Length == 10000, $"Expected stream length to be 10000, but got {stream.Length}");
+			        int index = 0;
+			        bool matches = true;
+			        int[] firstBuffer = null;
+			        foreach (ArraySegment<int> chunk in stream.ReadChunks<int>(333))
+			        {
+				        firstBuffer = firstBuffer ?? chunk.Array;
+				        matches &= ReferenceEquals(chunk.Array, firstBuffer) && chunk.Count <= 333;
+				        for (int i = 0; i < chunk.Count; ++i, ++index)
+				        {
+					        matches &= chunk.Array[chunk.Offset + i] == index * 3 - 1;
+				        }
+			        }
+					Assert(matches && index == 10000, $"Expected ReadChunks() to return 10000 elements through one buffer, but got {index}");
+					Assert(stream.Position == 10000, $"Expected stream position to be 10000, but got {stream.Position}");
+					Assert(stream.Read(new int[4], 0, 4) == 0, "Expected Read() at the end of the stream to return 0");
+		        }
+
+		        using (NativeArrayStream stream = ReturnLargeArray(5))
+		        {
+			        int[] head = new int[2];
+					Assert(stream.Read(head, 0, 2) == 2 && head.SequenceEqual(new[] { -1, 2 }), $"Expected Read() to return (-1, 2), but got {string.Join(", ", head)}");
+			        int[] rest = stream.ToArray<int>();
+					Assert(rest.SequenceEqual(new[] { 5, 8, 11 }), $"Expected ToArray() to return remaining (5, 8, 11), but got {string.Join(", ", rest)}");
+		        }
+
+		        using (NativeArrayStream stream = ReturnLargeArray(0))
+		        {
+					Assert(stream.Length == 0 && stream.ToArray<int>().Length == 0, "Expected empty stream");
+					Assert(!stream.ReadChunks<int>().Any(), "Expected no chunks from empty stream");
+		        }
+
+		        // Element type must be exactly the managed type of native element
+		        using (NativeArrayStream stream = ReturnLargeArray(1))
+		        {
+			        bool rejected = false;
+			        try
+			        {
+				        stream.Read(new float[1], 0, 1);
+			        }
+			        catch (ArgumentException)
+			        {
+				        rejected = true;
+			        }
+					Assert(rejected, "Expected Read() into float[] from int stream to throw");
+		        }
+
+		        // Producer stream has unknown length until the producer returns 0
+		        using (NativeArrayStream stream = NativeArrayStream.Open<int>("cpp_test", "ProduceSquares"))
+		        {
+					Assert(stream.Length == -1, $"Expected producer stream length to be -1, but got {stream.Length}");
+			        int index = 0;
+			        bool matches = true;
+			        foreach (ArraySegment<int> chunk in stream.ReadChunks<int>(64))
+			        {
+				        for (int i = 0; i < chunk.Count; ++i, ++index)
+				        {
+					        matches &= chunk.Array[chunk.Offset + i] == index * index;
+				        }
+			        }
+					Assert(matches && index == 1000, $"Expected producer stream to return 1000 squares, but got {index}");
+					Assert(stream.Length == 1000, $"Expected producer stream length to be 1000 at the end, but got {stream.Length}");
+		        }
+
+		        using (NativeArrayStream stream = NativeArrayStream.Open<int>("cpp_test", "ProduceSquares"))
+		        {
+			        int[] squares = stream.ToArray<int>();
+					Assert(squares.Length == 1000 && squares[999] == 999 * 999, $"Expected ToArray() to return 1000 squares, but got {squares.Length}");
+		        }
+
+		        bool invalid = false;
+		        try
+		        {
+			        NativeArrayStream.Open<int>("cpp_test", "MulAdd");
+		        }
+		        catch (InvalidOperationException)
+		        {
+			        invalid = true;
+		        }
+				Assert(invalid, "Expected Open() of method without producer signature to throw");
+	        }
+	        
 	        Console.WriteLine("All tests passed!");
         }
         
@@ -1,4 +1,5 @@
 ﻿using System;
+using System.Linq;
 using System.Numerics;
 using Plugify;
 
@@ -436,5 +437,193 @@ namespace CSharpTest
             sum += Convert.ToInt64(p13);
             return sum;
         }
+
+        // Round trips (array kernels)
+
+        public static bool[] RoundTripArrayBool(bool[] a)
+        {
+            return a;
+        }
+
+        public static char[] RoundTripArrayChar8(char[] a)
+        {
+            return a;
+        }
+
+        // Round trips (UTF-8 <-> UTF-16)
+
+        public static string RoundTripString(string a)
+        {
+            return a;
+        }
+
+        public static int GetStringLength(string a)
+        {
+            return a.Length;
+        }
+
+        public static string ReturnLoneSurrogates()
+        {
+            // High without low, low without high, swapped pair and high at the very end
+            return "a\uD800b\uDC00\uDE00\uD83Dc\uD83D";
+        }
+
+        // Round trips (jagged arrays)
+
+        public static int[][] RoundTripJaggedInt(int[][] a)
+        {
+            return a;
+        }
+
+        public static string[][] RoundTripJaggedString(string[][] a)
+        {
+            return a;
+        }
+
+        public static int[][] ReturnJaggedWithNullRow()
+        {
+            return new int[][] { new[] { 1, 2 }, null, new int[0], new[] { 3 } };
+        }
+
+        // Narrow integers and floats (call thunks)
+
+        public static double ParamNarrowSum(sbyte a, byte b, short c, ushort d, bool e, char f, float g, double h)
+        {
+            return a + b + c + d + (e ? 1 : 0) + f + g + h;
+        }
+
+        // Batch form
+
+        public static double MulAdd(int a, float b, double c)
+        {
+            return a * b + c;
+        }
+
+        // User structs (described under "structs" in mono-lang-module.json)
+
+        public static float GetPointWeight(TestPoint p)
+        {
+            return (p.X + p.Y) * p.Weight;
+        }
+
+        public static void MovePoint(ref TestPoint p, int dx, int dy)
+        {
+            p.X += dx;
+            p.Y += dy;
+        }
+
+        public static int SumPoints(TestPoint[] points)
+        {
+            if (points == null)
+                return -1;
+            int sum = 0;
+            foreach (var p in points)
+                sum += p.X + p.Y;
+            return sum;
+        }
+    }
+
+    public struct TestPoint
+    {
+        public int X;
+        public int Y;
+        public float Weight;
+
+        // Vector and matrix arrays (flat float arrays on native side)
+
+        public static Vector3[] RoundTripVector3Array(Vector3[] a)
+        {
+            return a;
+        }
+
+        public static Matrix4x4[] TransposeMatrices(Matrix4x4[] a)
+        {
+            return a?.Select(Matrix4x4.Transpose).ToArray();
+        }
+
+        public static int CountVector3(Vector3[] a)
+        {
+            return a?.Length ?? -1;
+        }
+
+        public static void AppendVector2(ref Vector2[] a)
+        {
+            a = a.Append(new Vector2(a.Length, -a.Length)).ToArray();
+        }
+
+        // Into forms
+
+        public static string RepeatString(string s, int count)
+        {
+            return string.Concat(Enumerable.Repeat(s, count));
+        }
+
+        public static int[] MakeRange(int count)
+        {
+            return count >= 0 ? Enumerable.Range(0, count).ToArray() : null;
+        }
+
+        // Native views
+
+        public static int GrowVector(NativeVector<int> v)
+        {
+            int length = v.Length;
+            if (length != 0)
+                v[0] = -v[0];
+            v.Resize(length + 2);
+            v[length] = length;
+            v.Add(7);
+            return v.Length;
+        }
+
+        public static void AppendBytes(NativeVector<byte> s)
+        {
+            s.Add((byte) '!');
+        }
+
+        public static void ClearVector(NativeVector<double> v)
+        {
+            v.Clear();
+        }
+
+        public static long SumSpan(NativeSpan<long> s)
+        {
+            long sum = 0;
+            for (int i = 0; i < s.Length; ++i)
+                sum += s[i];
+            return sum;
+        }
+
+        public static int CountSpaces(NativeString s)
+        {
+            int count = 0;
+            for (int i = 0; i < s.Length; ++i)
+            {
+                if (s[i] == (byte) ' ')
+                    ++count;
+            }
+            return count;
+        }
+
+        // Lazily decoded string lists
+
+        private static NativeStringList _keptStrings;
+
+        public static string JoinStrings(NativeStringList list)
+        {
+            // Last element is decoded first, so every element is read out of order once
+            string last = list.Count != 0 ? list[list.Count - 1] : null;
+            return $"{list.Count}:{string.Join("|", list)}:{last}";
+        }
+
+        public static void KeepStrings(NativeStringList list)
+        {
+            _keptStrings = list;
+        }
+
+        public static string GetKeptString(int index)
+        {
+            return _keptStrings[index];
+        }
     }
 }
\ No newline at end of file
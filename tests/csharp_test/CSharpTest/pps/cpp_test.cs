@@ -127,5 +127,17 @@ namespace cpp_test
 		internal static extern void ParamRefVectors(ref bool[] p1, ref char[] p2, ref char[] p3, ref sbyte[] p4, ref short[] p5, ref int[] p6, ref long[] p7, ref byte[] p8, ref ushort[] p9, ref uint[] p10, ref ulong[] p11, ref IntPtr[] p12, ref float[] p13, ref double[] p14, ref string[] p15);
 		[MethodImplAttribute(MethodImplOptions.InternalCall)]
 		internal static extern long ParamAllPrimitives(bool p1, char p2, sbyte p3, short p4, int p5, long p6, byte p7, ushort p8, uint p9, ulong p10, IntPtr p11, float p12, double p13);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern void ParamRefPartialUpdate(ref string p1, ref string p2, ref string[] p3, ref char[] p4, ref bool[] p5);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern double ParamNarrowSum(sbyte a, byte b, short c, ushort d, bool e, char f, float g, double h);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern double MulAdd(int a, float b, double c);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern string RepeatString(string s, int count);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern NativeArrayStream ReturnLargeArray(int count);
+		[MethodImplAttribute(MethodImplOptions.InternalCall)]
+		internal static extern ulong ProduceSquares(IntPtr buffer, ulong offset, ulong capacity);
 	}
 }